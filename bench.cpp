@@ -0,0 +1,327 @@
+#include <FEHLCD.h>
+#include <FEHRPS.h>
+#include <FEHSD.h>
+#include <FEHUtility.h>
+#include <cmath>
+#include <initializer_list>
+
+#include "module.hpp"
+#include "drive.hpp"
+#include "encoders.hpp"
+#include "motors.hpp"
+#include "profile.hpp"
+#include "rps.hpp"
+#include "trajectory.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
+#include "turns.hpp"
+#include "watchdog.hpp"
+
+const char *BenchModule::name() const {
+    return "Benchmarks";
+}
+
+// times one straight move and measures where it ended up with RPS
+static void benchMove(FEHFile *f, const char *impl, void (*move)(float), float distance) {
+    // each run gets a fresh start; trips are in the log at the end
+    watchdog.clear();
+    rpsSettle();
+    Point start = rpsToPoint();
+    float startTime = TimeNow();
+    move(distance);
+    float elapsed = TimeNow() - startTime;
+    rpsSettle();
+    Point end = rpsToPoint();
+    float error = distance - pythagoreanDistance(start, end);
+    // sideways off the line we set off along
+    float h = toRadians(start.heading);
+    float drift = -(end.x - start.x) * std::sin(h) + (end.y - start.y) * std::cos(h);
+
+    console.write(impl);
+    console.write(" ");
+    console.write(distance);
+    console.write(": ");
+    console.write(elapsed);
+    console.write("s err ");
+    console.write(error);
+    console.write(" drift ");
+    console.writeLine(drift);
+    SD.FPrintf(f, "%s\t%f\t%f\t%f\t%f\n", impl, distance, elapsed, error, drift);
+
+    // face back the way we came for the next run
+    watchdog.clear();
+    turnTo((Angle(start.heading) + 180.f).degrees());
+}
+
+// open loop, fast; shows how straight the motors are matched
+static void coarseFast(float distance) {
+    coarseMoveInline(70, distance);
+}
+
+static void benchDrive(FEHFile *f) {
+    static const float distances[] = { 4.f, 8.f, 12.f, 18.f };
+    SD.FPrintf(f, "# drive: impl\tdistance\ttime\terror\tdrift\n");
+    for (float d : distances) {
+        benchMove(f, "pulse", pulseMoveInline, d);
+        benchMove(f, "profiled", profiledMoveInline, d);
+        benchMove(f, "coarse70", coarseFast, d);
+    }
+}
+
+// one turn of {degrees} with each controller, and back again
+static void benchTurn(FEHFile *f, float degrees) {
+    for (float d : { degrees, -degrees }) {
+        watchdog.clear();
+        rpsSettle();
+        float target = (Angle(RPS.Heading()) + d).degrees();
+        float startTime = TimeNow();
+        pulseTurnTo(target);
+        float elapsed = TimeNow() - startTime;
+        rpsSettle();
+        SD.FPrintf(f, "pulse\t%f\t%f\t-\t%f\n", d, elapsed, Angle(target) - Angle(RPS.Heading()));
+    }
+    for (float d : { degrees, -degrees }) {
+        watchdog.clear();
+        rpsSettle();
+        TurnStats stats = headingTurnTo((Angle(RPS.Heading()) + d).degrees());
+        SD.FPrintf(f, "heading\t%f\t%f\t%f\t%f\n", d, stats.time, stats.overshoot, stats.error);
+
+        console.write("turn ");
+        console.write(d);
+        console.write(": ");
+        console.write(stats.time);
+        console.write("s over ");
+        console.writeLine(stats.overshoot);
+    }
+}
+
+static void benchTurns(FEHFile *f) {
+    static const float angles[] = { 2.f, 5.f, 10.f, 20.f, 45.f, 90.f, 135.f, 180.f };
+    SD.FPrintf(f, "# turn: impl\tdegrees\ttime\tovershoot\terror\n");
+    for (float a : angles)
+        benchTurn(f, a);
+}
+
+// drives to a pose {forward, left, turn} relative to where we are with
+// {plan}, then goes back
+static void benchPose(FEHFile *f, bool fastest, float forward, float left, float turn) {
+    watchdog.clear();
+    rpsSettle();
+    Point start = rpsToPoint();
+    float h = toRadians(start.heading);
+    Point target = { start.x + forward * std::cos(h) - left * std::sin(h),
+                     start.y + forward * std::sin(h) + left * std::cos(h),
+                     (Angle(start.heading) + turn).degrees() };
+
+    Trajectory t = fastest ? planFastest(start, target, true) : planPivot(start, target, true);
+    float startTime = TimeNow();
+    runTrajectory(t, target);
+    float elapsed = TimeNow() - startTime;
+    rpsSettle();
+    Point end = rpsToPoint();
+    SD.FPrintf(f, "%s\t%f\t%f\t%f\t%f\t%f\t%f\t%f\n", t.name, forward, left, turn, t.time, elapsed,
+               pythagoreanDistance(end, target), wrapDegrees(end.heading - target.heading));
+
+    console.write(t.name);
+    console.write(": ");
+    console.write(elapsed);
+    console.write("s est ");
+    console.writeLine(t.time);
+
+    watchdog.clear();
+    moveToWithTurn(start);
+}
+
+static void benchTrajectories(FEHFile *f) {
+    static const float poses[][3] = {
+        { 12.f, 0.f, 0.f }, { 12.f, 4.f, 30.f }, { 10.f, 8.f, 90.f },
+        { 6.f, 12.f, 90.f }, { 14.f, -6.f, -45.f }, { 8.f, 8.f, 0.f },
+    };
+    SD.FPrintf(f, "# pose: plan\tforward\tleft\tturn\testimate\ttime\terror\theading error\n");
+    for (auto &p : poses) {
+        benchPose(f, false, p[0], p[1], p[2]);
+        benchPose(f, true, p[0], p[1], p[2]);
+    }
+}
+
+// percent the stop benchmarks drive at
+static constexpr int BENCH_STOP_PERCENT = 40;
+static constexpr int BENCH_IDLE_POLLS = 10000;
+
+// stands in for background work: a step per poll until told to stop
+class LoadTask : public Task {
+public:
+    const char *name() const { return "load"; }
+    void begin() { steps = 0; stop = false; }
+    bool step() { ++steps; return stop; }
+    int steps = 0;
+    bool stop = false;
+};
+
+// coarseMoveInline and pivotTurn as they were, spinning on the encoders.
+// Each returns the average count it stopped at less the target.
+static float spinMove(float distance) {
+    resetEncoders();
+    float speed = std::copysign(motorMap.nominalSpeed(BENCH_STOP_PERCENT), distance);
+    setSpeeds(speed, speed);
+    float counts = COUNTS_PER_LINEAR_INCH * std::fabs(distance);
+    float average;
+    while ((average = (hardware().leftEncoder.Counts() + hardware().rightEncoder.Counts()) / 2.f) < counts)
+        scheduler.poll();
+    setMotors(0.f, 0.f);
+    return average - counts;
+}
+
+static float spinPivot(float degrees) {
+    float counts = std::fabs(COUNTS_PER_DEGREE * turnTable.command(degrees, TURNPERCENT));
+    setMotors(0.f, 0.f);
+    resetEncoders();
+    float speed = motorMap.nominalSpeed(TURNPERCENT);
+    setSpeeds(degrees > 0 ? -speed : speed, degrees > 0 ? speed : -speed);
+    float startTime = TimeNow();
+    int sum;
+    while ((sum = hardware().leftEncoder.Counts() + hardware().rightEncoder.Counts()) < counts && TimeNow() - startTime < 4)
+        scheduler.poll();
+    setMotors(0.f, 0.f);
+    return (sum - counts) / 2.f;
+}
+
+static float monitorMove(float distance) {
+    coarseMoveInline(BENCH_STOP_PERCENT, distance);
+    return encoderMonitor.lastOvershoot();
+}
+
+static float monitorPivot(float degrees) {
+    pivotTurn(degrees);
+    return encoderMonitor.lastOvershoot();
+}
+
+// runs {move} there and back with a background task going, and logs how
+// far past its target each stopped and what share of an idle foreground's
+// polls the task still got
+static void benchStop(FEHFile *f, const char *impl, float (*move)(float), float amount, float idleRate) {
+    for (float a : { amount, -amount }) {
+        watchdog.clear();
+        LoadTask load;
+        scheduler.start(load);
+        float startTime = TimeNow();
+        float overshoot = move(a);
+        float elapsed = TimeNow() - startTime;
+        int steps = load.steps;
+        load.stop = true;
+        scheduler.join(load);
+        float available = steps / elapsed / idleRate;
+        SD.FPrintf(f, "%s\t%f\t%f\t%f\t%f\n", impl, a, elapsed, overshoot, available);
+        scheduler.wait(PULSE_WIDTH / 1000.f);
+    }
+
+    console.write(impl);
+    console.write(" ");
+    console.write(amount);
+    console.writeLine(" done");
+}
+
+static void benchStops(FEHFile *f) {
+    static const float distances[] = { 2.f, 6.f, 12.f };
+    static const float angles[] = { 15.f, 45.f, 90.f, 180.f };
+
+    // polls per second with nothing else in the foreground
+    LoadTask load;
+    scheduler.start(load);
+    float startTime = TimeNow();
+    for (int i = 0; i < BENCH_IDLE_POLLS; ++i)
+        scheduler.poll();
+    float idleRate = load.steps / (TimeNow() - startTime);
+    load.stop = true;
+    scheduler.join(load);
+
+    SD.FPrintf(f, "# stop: impl\tamount\ttime\tovershoot (counts)\tavailable\n");
+    for (float d : distances) {
+        benchStop(f, "spin move", spinMove, d, idleRate);
+        benchStop(f, "monitor move", monitorMove, d, idleRate);
+    }
+    for (float a : angles) {
+        benchStop(f, "spin pivot", spinPivot, a, idleRate);
+        benchStop(f, "monitor pivot", monitorPivot, a, idleRate);
+    }
+    encoderMonitor.write(f);
+}
+
+enum DisplayMode { CONSOLE, OVERLAY, NO_DISPLAY };
+
+// spins a stand-in control loop for {seconds} showing its state the old
+// way (clear and rewrite every pass), through the status overlay, or not
+// at all, and logs how long a pass takes
+static void benchDisplayMode(FEHFile *f, DisplayMode mode, float seconds) {
+    static const char *const names[] = { "console", "overlay", "none" };
+    status.enable(mode == OVERLAY);
+    status.redraw();
+
+    int passes = 0;
+    float worst = 0.f;
+    float startTime = TimeNow(), last = startTime;
+    while (last - startTime < seconds) {
+        scheduler.poll();
+        float heading = RPS.Heading();
+        int counts = hardware().leftEncoder.Counts() + hardware().rightEncoder.Counts();
+        if (mode == CONSOLE) {
+            console.clear();
+            console.write("Intended angle: ");
+            console.writeLine(90.f);
+            console.write("Current angle: ");
+            console.writeLine(heading);
+        } else if (mode == OVERLAY) {
+            status.set("target", 90.f);
+            status.set("heading", heading);
+            status.set("counts", static_cast<float>(counts));
+        }
+        float now = TimeNow();
+        worst = std::fmax(worst, now - last);
+        last = now;
+        ++passes;
+    }
+    float mean = (last - startTime) / passes;
+    SD.FPrintf(f, "%s\t%d\t%f\t%f\n", names[mode], passes, mean, worst);
+    status.enable(true);
+
+    console.write(names[mode]);
+    console.write(": ");
+    console.write(mean * 1000.f);
+    console.write("ms worst ");
+    console.writeLine(worst * 1000.f);
+}
+
+static void benchDisplay(FEHFile *f) {
+    SD.FPrintf(f, "# display: mode\tpasses\tmean pass\tworst pass\n");
+    for (DisplayMode mode : { CONSOLE, OVERLAY, NO_DISPLAY })
+        benchDisplayMode(f, mode, 2.f);
+}
+
+int BenchModule::run() {
+    RPS.InitializeTouchMenu();
+
+    loadDriveCalibration();
+
+    FEHFile *f = SD.FOpen("bench.txt", "w");
+    benchDrive(f);
+    benchTurns(f);
+    benchTrajectories(f);
+    benchStops(f);
+    benchDisplay(f);
+    SD.FClose(f);
+
+    f = SD.FOpen("watchdog.txt", "w");
+    watchdog.write(f);
+    SD.FClose(f);
+
+    f = SD.FOpen("rps.txt", "w");
+    rpsSampler.write(f);
+    SD.FClose(f);
+
+    f = SD.FOpen("profile.txt", "w");
+    writeProfile(f);
+    SD.FClose(f);
+
+    console.writeLine("Goodbye.");
+    return 0;
+}
@@ -0,0 +1,28 @@
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "boot.hpp"
+
+BootConfig bootConfig = {"", BOOT_WINDOW, "position.dat"};
+
+bool loadBootConfig(FEHFile *file, BootConfig &config)
+{
+    if (!file)
+        return false;
+    char key[16], value[32];
+    int n;
+    while ((n = SD.FScanf(file, "%15s%31s", key, value)) == 2)
+    {
+        if (std::strcmp(key, "module") == 0 && std::strlen(value) < BOOT_NAME_LEN)
+            std::strcpy(config.module, value);
+        else if (std::strcmp(key, "window") == 0)
+            config.window = std::fmax(0.f, std::strtof(value, nullptr));
+        else if (std::strcmp(key, "positions") == 0 && std::strlen(value) < BOOT_FILE_LEN)
+            std::strcpy(config.positions, value);
+        else
+            return false;
+    }
+    return n == EOF;
+}
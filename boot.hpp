@@ -0,0 +1,32 @@
+#pragma once
+
+#include <FEHSD.h>
+
+// read from SD by main() before anything else
+static constexpr const char *BOOT_CONFIG = "autorun.txt";
+// how long the autorun banner waits for a touch, s, unless it says
+static constexpr float BOOT_WINDOW = 1.5f;
+static constexpr int BOOT_NAME_LEN = 20; // menu labels are 20 long
+static constexpr int BOOT_FILE_LEN = 13; // 8.3 and the terminator
+
+// autorun.txt: lines of
+//   key value
+// with keys
+//   module     menu entry to run without the menu, spaces as underscores
+//   window     s to touch the banner for the menu instead
+//   positions  where CalibrationModule writes the waypoints and the
+//              course reads them, for keeping a set per course
+// Anything left out keeps its default: no module, which is the menu,
+// BOOT_WINDOW and position.dat.
+struct BootConfig
+{
+    char module[BOOT_NAME_LEN];
+    float window;
+    char positions[BOOT_FILE_LEN];
+};
+
+extern BootConfig bootConfig;
+
+// false if {file} is missing or has a line it doesn't understand; {config}
+// keeps whatever came before that line
+bool loadBootConfig(FEHFile *file, BootConfig &config);
@@ -1,54 +1,128 @@
 #include <FEHLCD.h>
 #include <FEHRPS.h>
 #include <FEHSD.h>
+#include <FEHUtility.h>
+#include <cstdio>
 
 #include "module.hpp"
+#include "boot.hpp"
+#include "capture.hpp"
+#include "encoders.hpp"
+#include "positions.hpp"
+#include "rps.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
 
-const std::string &CalibrationModule::name() const {
-    static const std::string mod_name("Calibrate to SD");
-    return mod_name;
+const char *CalibrationModule::name() const {
+    return "Calibrate to SD";
 }
 
 int CalibrationModule::run() {
     RPS.InitializeTouchMenu();
 
-    LCD.WriteLine("Initializing SD file");
-	FEHFile *f = SD.FOpen("position.txt", "w");
-    Sleep(1000);
+    // a skipped waypoint keeps what it had, if there was anything
+    Point points[WAYPOINT_COUNT];
+    PositionSpread spreads[WAYPOINT_COUNT];
+    FEHFile *f = SD.FOpen(bootConfig.positions, "r");
+    if (loadPositions(f, points, spreads) != POSITIONS_OK) {
+        for (int i = 0; i < WAYPOINT_COUNT; ++i) {
+            points[i] = {-1.f, -1.f, -1.f};
+            spreads[i] = {-1.f, -1.f};
+        }
+    }
+    if (f)
+        SD.FClose(f);
 
     LCD.ClearBuffer();
 
-	int lcdX, lcdY;
+	float lcdX, lcdY;
+    WaypointCapture capture;
+
+    for (int i = 0; i < WAYPOINT_COUNT; ++i) {
+        const char *prompt = prompts[i];
+        console.write("\nPlace robot and touch to\ncapture ");
+        console.writeLine(prompt);
+        status.set("point", prompt);
+        status.set("n", "-");
+        while (!LCD.Touch(&lcdX, &lcdY)) {
+            const Point &fix = rpsSampler.latest().pt;
+            status.set("X", fix.x);
+            status.set("Y", fix.y);
+            status.set("A", fix.heading);
+            scheduler.wait(.05f);
+        }
+        // or a finger still down would go on to the next waypoint
+        while (LCD.Touch(&lcdX, &lcdY))
+            scheduler.poll();
 
-    for (const char *prompt : prompts) {
+        // every packet from when the robot's stopped rocking from the touch,
+        // until the mean's stable; it starts over if the wheels turn
+        capture.reset();
+        float start = TimeNow();
+        int packets = rpsSampler.count();
+        bool captured = false;
         while (true) {
-            LCD.Clear();
-            float x = RPS.X(), y = RPS.Y(), angle = RPS.Heading();
-            LCD.SetFontColor(0xFFFFFF);
-            LCD.Write("X: ");
-            LCD.WriteLine(x);
-            LCD.Write("Y: ");
-            LCD.WriteLine(y);
-            LCD.Write("A: ");
-            LCD.WriteLine(angle);
-            LCD.Write("\nTouch screen to record\ncoords for ");
-            LCD.WriteLine(prompt);
-
-            if (LCD.Touch(&lcdX, &lcdY) && x > 0 && y > 0 && angle > 0) {
-                SD.FPrintf(f, "%f\t%f\t%f\n", x, y, angle);
+            scheduler.poll();
+            float now = TimeNow();
+            if (now - start > CAPTURE_TIMEOUT) {
+                // take what there is, if it's enough
+                if (capture.result().samples >= CAPTURE_MIN_SAMPLES) {
+                    captured = true;
+                    break;
+                }
+                // RPS has gone quiet, or only says dead zone
+                console.writeLine("No RPS fix. Touch left to");
+                console.writeLine("retry, right to skip");
+                while (!LCD.Touch(&lcdX, &lcdY))
+                    scheduler.wait(.05f);
+                float touchX = lcdX;
+                while (LCD.Touch(&lcdX, &lcdY))
+                    scheduler.poll();
+                if (touchX >= 160.f)
+                    break;
+                capture.reset();
+                start = TimeNow();
+                continue;
+            }
+            if (rpsSampler.count() == packets)
+                continue;
+            packets = rpsSampler.count();
+            if (now - encoderMonitor.lastMoved() < CAPTURE_SETTLE || now - start < CAPTURE_SETTLE) {
+                capture.reset();
+                continue;
+            }
+            capture.add(rpsSampler.latest().pt);
+            bool stable = capture.update();
+            const CaptureResult &r = capture.result();
+            status.set("X", r.mean.x);
+            status.set("Y", r.mean.y);
+            status.set("A", r.mean.heading);
+            status.set("n", static_cast<float>(r.samples));
+            if (stable) {
+                captured = true;
                 break;
             }
+        }
 
-            Sleep(100);
+        if (!captured) {
+            console.writeLine(points[i].x < 0.f ? "Skipped" : "Skipped, kept the old one");
+            continue;
         }
-        Sleep(1000);
+        const CaptureResult &r = capture.result();
+        points[i] = r.mean;
+        spreads[i] = {r.spreadXY, r.spreadHeading};
+        char line[32];
+        std::snprintf(line, sizeof line, "%d fixes, +-%.2f in %.1f deg", r.samples, r.spreadXY, r.spreadHeading);
+        console.writeLine(line);
 	}
 
-    SD.FPrintf(f, "\n\n");
+    // only now, so stopping partway leaves the last calibration be
+    f = SD.FOpen(bootConfig.positions, "w");
+    savePositions(f, points, spreads);
     SD.FClose(f);
 
-    LCD.Clear();
-    LCD.WriteLine("Goodbye.");
+    console.clear();
+    console.writeLine("Goodbye.");
 
     return 0;
 }
\ No newline at end of file
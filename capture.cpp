@@ -0,0 +1,78 @@
+#include <algorithm>
+#include <cmath>
+
+#include "capture.hpp"
+
+// median of {v}, reordering it
+static float median(float *v, int n)
+{
+    std::nth_element(v, v + n / 2, v + n);
+    return v[n / 2];
+}
+
+void WaypointCapture::add(Point fix)
+{
+    if (fix.x < 0.f || fix.y < 0.f || fix.heading < 0.f)
+        return;
+    _samples[_count % CAPTURE_MAX_SAMPLES] = fix;
+    ++_count;
+}
+
+bool WaypointCapture::update()
+{
+    int n = std::min(_count, CAPTURE_MAX_SAMPLES);
+    _result = {};
+    if (n == 0)
+        return false;
+
+    // headings as turns from the first, so the median doesn't straddle 0
+    float xs[CAPTURE_MAX_SAMPLES], ys[CAPTURE_MAX_SAMPLES], turns[CAPTURE_MAX_SAMPLES];
+    Angle ref(_samples[0].heading);
+    for (int i = 0; i < n; ++i)
+    {
+        xs[i] = _samples[i].x;
+        ys[i] = _samples[i].y;
+        turns[i] = Angle(_samples[i].heading) - ref;
+    }
+    Point mid = {median(xs, n), median(ys, n), median(turns, n)};
+
+    float sx = 0.f, sy = 0.f, sh = 0.f;
+    int inliers = 0;
+    for (int i = 0; i < n; ++i)
+    {
+        const Point &s = _samples[i];
+        float turn = Angle(s.heading) - ref;
+        if (pythagoreanDistance(s, mid) > CAPTURE_OUTLIER_XY || std::fabs(turn - mid.heading) > CAPTURE_OUTLIER_HEADING)
+            continue;
+        xs[inliers] = s.x;
+        ys[inliers] = s.y;
+        turns[inliers] = turn;
+        sx += s.x;
+        sy += s.y;
+        sh += turn;
+        ++inliers;
+    }
+    if (inliers < n - inliers)
+    {
+        reset();
+        return false;
+    }
+
+    Point mean = {sx / inliers, sy / inliers, sh / inliers};
+    float xy = 0.f, heading = 0.f;
+    for (int i = 0; i < inliers; ++i)
+    {
+        xy += (xs[i] - mean.x) * (xs[i] - mean.x) + (ys[i] - mean.y) * (ys[i] - mean.y);
+        heading += (turns[i] - mean.heading) * (turns[i] - mean.heading);
+    }
+    int dof = std::max(inliers - 1, 1);
+    _result.spreadXY = std::sqrt(xy / dof);
+    _result.spreadHeading = std::sqrt(heading / dof);
+    _result.mean = {mean.x, mean.y, (ref + mean.heading).degrees()};
+    _result.samples = inliers;
+    _result.rejected = n - inliers;
+
+    float root = std::sqrt(static_cast<float>(inliers));
+    return inliers >= CAPTURE_MIN_SAMPLES && _result.spreadXY / root <= CAPTURE_SEM_XY &&
+           _result.spreadHeading / root <= CAPTURE_SEM_HEADING;
+}
@@ -0,0 +1,48 @@
+#pragma once
+
+#include "geometry.hpp"
+
+// the most recent this many fixes are kept
+static constexpr int CAPTURE_MAX_SAMPLES = 40;
+// fixes from this long after a touch or the wheels turning are skipped, s
+static constexpr float CAPTURE_SETTLE = .3f;
+// after this long, s, take what there is if it's CAPTURE_MIN_SAMPLES
+static constexpr float CAPTURE_TIMEOUT = 5.f;
+// fewest inliers worth averaging
+static constexpr int CAPTURE_MIN_SAMPLES = 8;
+// stable once the mean's standard error is this small
+static constexpr float CAPTURE_SEM_XY = .03f;
+static constexpr float CAPTURE_SEM_HEADING = .2f;
+// fixes this far from the median are outliers
+static constexpr float CAPTURE_OUTLIER_XY = .5f;
+static constexpr float CAPTURE_OUTLIER_HEADING = 3.f;
+
+struct CaptureResult
+{
+    Point mean;
+    float spreadXY;      // rms distance of the inliers from the mean, in
+    float spreadHeading; // their standard deviation, degrees
+    int samples, rejected;
+};
+
+// Averages a stream of RPS fixes taken while the robot sits on a waypoint.
+// Each update() takes the median of what's in, drops fixes too far from it
+// and averages the rest. Headings go in as turns from the fix in the first
+// slot, and their median and mean are of those turns, so a waypoint at
+// 0/360 comes out right. When the outliers outnumber the rest the robot's
+// been moved, so it starts again.
+class WaypointCapture
+{
+public:
+    void reset() { _count = 0; }
+    // invalid fixes (RPS's negative sentinels) are ignored
+    void add(Point fix);
+    // true once there are enough inliers and the mean's settled
+    bool update();
+    const CaptureResult &result() const { return _result; }
+
+private:
+    Point _samples[CAPTURE_MAX_SAMPLES];
+    int _count = 0;
+    CaptureResult _result = {};
+};
@@ -5,144 +5,112 @@
 #include <FEHRPS.h>
 #include <FEHSD.h>
 #include <cmath>
+#include <initializer_list>
 
 #include "module.hpp"
+#include "drive.hpp"
+#include "profile.hpp"
+#include "rps.hpp"
+#include "status.hpp"
+#include "turns.hpp"
 
-static AnalogInputPin cds(FEHIO::P0_0);
+// turns checked with the fitted table, each way, at TURNPERCENT
+static constexpr float TURN_CHECKS[] = {10.f, 45.f, 90.f, 135.f};
 
-
-static FEHMotor leftMotor(FEHMotor::Motor0, 9);
-static FEHMotor rightMotor(FEHMotor::Motor3, 9);
-static DigitalEncoder leftEncoder(FEHIO::P1_0);  // declaring input pin
-static DigitalEncoder rightEncoder(FEHIO::P1_7); // declaring input pin
-
-
-
-static constexpr float AXLETRACK = 7.86f;
-static constexpr float WHEELDIAM = 2.41f;
-static constexpr float TURNPERCENT = 20.f;
-static constexpr float CORRECTION_MULTIPLIER = 1.0711f;
-static constexpr float COUNTS_PER_DEGREE = CORRECTION_MULTIPLIER * (318.f * AXLETRACK / (180.F * WHEELDIAM));
-// THEORETICAL COUNT PER DEGREE : 3.085
-
-// test code for motor shaft encoders
-static constexpr float COUNTS_PER_LINEAR_INCH = 318.0 * 7 / (2 * 22 * (WHEELDIAM / 2));
-
-
-
-static constexpr int PULSE_WIDTH = 200;
-
-static constexpr float PULSE_ANGLE = .5f;
-static constexpr float HEADING_THRESHOLD = 1.f;
-
-const std::string &CDSModule::name() const {
-    static const std::string mod_name("Get CDS values");
-    return mod_name;
+const char *CDSModule::name() const {
+    return "Get CDS values";
 }
 
-// moves both wheels forward {distance} inches at {percent} motor percent.
-static void coarseMoveInline(int percent, float distance)
-{
-    // Reset encoder counts
-    rightEncoder.ResetCounts();
-    leftEncoder.ResetCounts();
-
-    // Set both motors to desired percent
-    rightMotor.SetPercent(std::copysign(percent + 1, distance));
-    leftMotor.SetPercent(std::copysign(percent, distance));
-
-    float counts = COUNTS_PER_LINEAR_INCH * std::fabs(distance);
-
-    // While the average of the left and right encoder is less than counts,
-    // keep running motors
-    while ((leftEncoder.Counts() + rightEncoder.Counts()) / 2. < counts)
-        ;
-
-    // Turn off motors
-    rightMotor.Stop();
-    leftMotor.Stop();
+// pivots {degrees} and measures how far it really went with RPS; false if
+// RPS had no fix either side
+static bool measureTurn(float degrees, float percent, float &achieved) {
+    PROFILE_SCOPE("measureTurn");
+    status.set("target", degrees);
+    rpsSettle();
+    float start = RPS.Heading();
+    pivotTurn(degrees, percent);
+    rpsSettle();
+    float end = RPS.Heading();
+    if (start < 0.f || end < 0.f)
+        return false;
+    achieved = degrees + wrapDegrees(end - start - degrees);
+    status.set("heading", achieved);
+    return true;
 }
 
-// turns a specified degrees, about center of axle track
-static void pivotTurn(float degrees)
-{
-    float counts = COUNTS_PER_DEGREE * degrees;
-
-    leftMotor.Stop();
-    rightMotor.Stop();
-    rightEncoder.ResetCounts();
-    leftEncoder.ResetCounts();
+// Sweeps pivot turns with the table cleared and fits a fresh one, then
+// checks a few turns with it. The raw sweep goes to error.txt, the table
+// to turns.txt. Turns alternate direction so the robot stays about where
+// it started.
+int CDSModule::run() {
+    RPS.InitializeTouchMenu();
+    loadDriveCalibration();
+    turnTable.clear();
 
-    if (degrees > 0)
-    {
-        leftMotor.SetPercent(-TURNPERCENT);
-        rightMotor.SetPercent(TURNPERCENT);
+    FEHFile *f = SD.FOpen("error.txt", "w");
+    SD.FPrintf(f, "# sweep: percent\tasked\tachieved\n");
+
+    TurnTable fitted;
+    for (float percent : TURN_SWEEP_PERCENTS) {
+        float asked[2][TURN_SWEEP_TURNS], achieved[2][TURN_SWEEP_TURNS];
+        int n[2] = {0, 0};
+        for (int k = 1; k <= TURN_SWEEP_TURNS; ++k) {
+            for (int side = 0; side < 2; ++side) {
+                float degrees = (side ? -TURN_SWEEP_STEP : TURN_SWEEP_STEP) * k;
+                float got;
+                if (!measureTurn(degrees, percent, got))
+                    continue;
+                SD.FPrintf(f, "%f\t%f\t%f\n", percent, degrees, got);
+                asked[side][n[side]] = std::fabs(degrees);
+                achieved[side][n[side]++] = side ? -got : got;
+            }
+        }
+        for (int side = 0; side < 2; ++side)
+            fitted.add(TurnTable::fit(side ? -1 : 1, percent, asked[side], achieved[side], n[side]));
     }
-    else if (degrees < 0)
-    {
-        counts *= -1.f;
-
-        leftMotor.SetPercent(TURNPERCENT);
-        rightMotor.SetPercent(-TURNPERCENT);
+    turnTable = fitted;
+
+    FEHFile *table = SD.FOpen("turns.txt", "w");
+    turnTable.save(table);
+    SD.FClose(table);
+
+    console.clear();
+    console.writeLine("dir pct gain offset rms");
+    for (int i = 0; i < turnTable.count(); ++i) {
+        const TurnTable::Row &r = turnTable.row(i);
+        console.write(r.dir);
+        console.write(" ");
+        console.write(r.percent);
+        console.write(" ");
+        console.write(r.gain);
+        console.write(" ");
+        console.write(r.offset);
+        console.write(" ");
+        console.writeLine(r.rms);
     }
 
-    float startTime = TimeNow();
-    while (/*!flSwitch.Value() && !frSwitch.Value() && */ (leftEncoder.Counts() + rightEncoder.Counts() < counts) && TimeNow() - startTime < 4)
-        ;
-
-    leftMotor.Stop();
-    rightMotor.Stop();
-}
-
-static void rpsPivotTurn(float headingDifference) {
-    float heading = RPS.Heading() + headingDifference;
-    pivotTurn((headingDifference>180)?(headingDifference-360):(headingDifference));
-
-    while (std::fabs(RPS.Heading() - heading) > HEADING_THRESHOLD)
-    {
-        LCD.Clear();
-        LCD.Write("Intended angle: ");
-        LCD.WriteLine(heading);
-        LCD.Write("Current angle: ");
-        LCD.WriteLine(RPS.Heading());
-        pivotTurn(std::copysign(PULSE_ANGLE, heading - RPS.Heading()));
-        Sleep(PULSE_WIDTH);
+    SD.FPrintf(f, "# check: asked\tachieved\terror\n");
+    float worst = 0.f;
+    for (float degrees : TURN_CHECKS) {
+        for (float d : {degrees, -degrees}) {
+            float got;
+            if (!measureTurn(d, TURNPERCENT, got))
+                continue;
+            SD.FPrintf(f, "%f\t%f\t%f\n", d, got, got - d);
+            worst = std::fmax(worst, std::fabs(got - d));
+        }
     }
-}
-
-struct Point
-{
-    float x;
-    float y;
-    float heading;
-};
+    SD.FClose(f);
+    console.write("Worst corrected turn off by ");
+    console.writeLine(worst);
 
-static Point rpsToPoint()
-{
-    return {RPS.X(), RPS.Y(), RPS.Heading()};
-}
+    f = SD.FOpen("rps.txt", "w");
+    rpsSampler.write(f);
+    SD.FClose(f);
 
-int CDSModule::run() {
-    RPS.InitializeTouchMenu();
-    Point startpts[36], endpts[36];
-    int idx = 0;
-    for (float i = -180.f; i <= 180.f; i += 10.f) {
-        if (i == 0.f) continue;
-        LCD.Write("Finding error for ");
-        LCD.WriteLine(i);
-        Sleep(200);
-        startpts[idx] = rpsToPoint();
-        rpsPivotTurn(i);
-        Sleep(200);
-        endpts[idx] = rpsToPoint();
-        ++i;
-    }
-    FEHFile *f = SD.FOpen("error.txt", "w");
-    for (int i = 0; i < 36; ++i) {
-        SD.FPrintf(f, "%f\t%f\t%f\t%f\n", startpts[i].x, startpts[i].y, endpts[i].x, endpts[i].y);
-    }
+    f = SD.FOpen("profile.txt", "w");
+    writeProfile(f);
     SD.FClose(f);
-    LCD.Clear();
-    LCD.WriteLine("Goodbye.");
+    console.writeLine("Goodbye.");
     return 0;
-}
\ No newline at end of file
+}
@@ -0,0 +1,414 @@
+#include <FEHIO.h>
+#include <FEHLCD.h>
+#include <FEHRPS.h>
+#include <FEHMotor.h>
+#include <FEHSD.h>
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "drive.hpp"
+#include "encoders.hpp"
+#include "pose.hpp"
+#include "profile.hpp"
+#include "rps.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
+#include "telemetry.hpp"
+#include "motors.hpp"
+#include "trajectory.hpp"
+#include "turns.hpp"
+#include "watchdog.hpp"
+
+Point rpsToPoint()
+{
+    return {RPS.X(), RPS.Y(), RPS.Heading()};
+}
+
+// all motor commands and encoder resets go through here so the pose
+// estimator can keep its odometry straight
+void setMotors(float left, float right)
+{
+    poseEstimator.command(left, right);
+    telemetry.command(left, right);
+    watchdog.command(left, right);
+    hardware().leftMotor.SetPercent(left);
+    hardware().rightMotor.SetPercent(right);
+}
+
+void setSpeeds(float left, float right)
+{
+    setMotors(motorMap.percent(MotorMap::LEFT, left), motorMap.percent(MotorMap::RIGHT, right));
+}
+
+void resetEncoders()
+{
+    poseEstimator.beforeReset();
+    encoderMonitor.beforeReset();
+    hardware().rightEncoder.ResetCounts();
+    hardware().leftEncoder.ResetCounts();
+    poseEstimator.afterReset();
+    encoderMonitor.afterReset();
+}
+
+void loadDriveCalibration()
+{
+    FEHFile *f = SD.FOpen("turns.txt", "r");
+    if (!turnTable.load(f))
+        console.writeLine("No turns.txt, pivots uncorrected");
+    if (f)
+        SD.FClose(f);
+
+    f = SD.FOpen("motors.txt", "r");
+    if (!motorMap.load(f))
+        console.writeLine("No motors.txt, motors taken as matched");
+    if (f)
+        SD.FClose(f);
+}
+
+// gives RPS time to catch up with a robot that's just stopped
+void rpsSettle()
+{
+    rpsSampler.settle();
+}
+
+// an encoder target's callback: stops the moment the target's reached
+static void stopMotors(void *)
+{
+    setMotors(0.f, 0.f);
+}
+
+// how long an encoder move going {counts} on each wheel at {speed} in/s
+// gets before it gives up
+static float moveTimeout(float counts, float speed)
+{
+    return MOVE_TIMEOUT_FACTOR * counts / (COUNTS_PER_LINEAR_INCH * std::fmax(speed, DRIVE_CREEP_SPEED)) + MOVE_TIMEOUT_SLACK;
+}
+
+// moves both wheels forward {distance} inches at the speed {percent} motor
+// percent gives on average, each side getting what it needs for that.
+void coarseMoveInline(int percent, float distance)
+{
+    PROFILE_SCOPE("coarseMoveInline");
+    if (watchdog.tripped())
+        return;
+
+    // Reset encoder counts
+    resetEncoders();
+
+    // Set both motors to desired speed
+    float speed = motorMap.nominalSpeed(percent);
+    setSpeeds(std::copysign(speed, distance), std::copysign(speed, distance));
+
+    // Stop once the average of the left and right encoder reaches counts
+    float counts = COUNTS_PER_LINEAR_INCH * std::fabs(distance);
+    if (!encoderMonitor.waitFor(counts, moveTimeout(counts, speed), stopMotors))
+        setMotors(0.f, 0.f);
+}
+
+// turns a specified degrees, about center of axle track, asking the
+// encoders for whatever turnTable says lands there
+void pivotTurn(float degrees, float percent)
+{
+    PROFILE_SCOPE("pivotTurn");
+    if (watchdog.tripped())
+        return;
+    // the other way is shorter; keeps +-180 as asked
+    if (std::fabs(degrees) > 180.f)
+        degrees = wrapDegrees(degrees);
+    // each wheel's share
+    float counts = std::fabs(COUNTS_PER_DEGREE * turnTable.command(degrees, percent)) / 2.f;
+
+    setMotors(0.f, 0.f);
+    resetEncoders();
+
+    float speed = motorMap.nominalSpeed(percent);
+    if (degrees > 0)
+    {
+        setSpeeds(-speed, speed);
+    }
+    else if (degrees < 0)
+    {
+        setSpeeds(speed, -speed);
+    }
+
+    if (!encoderMonitor.waitFor(counts, moveTimeout(counts, speed), stopMotors))
+        setMotors(0.f, 0.f);
+}
+
+// the old approach: coarse pivots, then 0.5 degree pulses.
+// kept around for comparison in BenchModule.
+void pulseTurnTo(float heading)
+{
+    PROFILE_SCOPE("pulseTurnTo");
+    if (watchdog.tripped())
+        return;
+    int coarse = 0, pulses = 0;
+    Convergence progress(PULSE_ANGLE / 2.f);
+    rpsSettle();
+    // coarse turn
+    float error = Angle(heading) - Angle(RPS.Heading());
+    while (std::fabs(error) > HEADING_THRESHOLD_COARSE) {
+        if (!progress.update(std::fabs(error) - HEADING_THRESHOLD_COARSE))
+            break;
+        pivotTurn(error);
+        rpsSettle();
+        error = Angle(heading) - Angle(RPS.Heading());
+        ++coarse;
+    }
+
+    // fine turn w/ RPS
+    status.set("target", heading);
+    while (std::fabs(error) > HEADING_THRESHOLD)
+    {
+        if (!progress.update(std::fabs(error) - HEADING_THRESHOLD))
+            break;
+        status.set("heading", RPS.Heading());
+        pivotTurn(std::copysign(PULSE_ANGLE, error));
+        rpsSettle();
+        error = Angle(heading) - Angle(RPS.Heading());
+        ++pulses;
+    }
+    PROFILE_COUNT("pulseTurnTo coarse turns", coarse);
+    PROFILE_COUNT("pulseTurnTo pulses", pulses);
+}
+
+// turns in place to {heading} under continuous control. The outer loop
+// takes the heading error from the pose estimator and asks for a turn rate
+// that ramps down as the error closes. The inner loop holds that rate on
+// the encoders.
+TurnStats headingTurnTo(float heading)
+{
+    PROFILE_SCOPE("headingTurnTo");
+    TurnStats stats = {0.f, 0.f, 0.f};
+    if (watchdog.tripped())
+        return stats;
+    float startTime = TimeNow();
+    status.set("target", heading);
+
+    while (!poseEstimator.valid() && TimeNow() - startTime < TURN_TIMEOUT)
+        scheduler.poll();
+    Point pose = poseEstimator.pose();
+    float timeout = TURN_TIMEOUT + std::fabs(wrapDegrees(heading - pose.heading)) / TURN_MAX_RATE;
+
+    resetEncoders();
+    int fixes = poseEstimator.fixes();
+    float dir = 0.f, firstDir = 0.f;
+    int passes = 0, stops = 0;
+    Convergence progress(HEADING_THRESHOLD / 2.f);
+
+    while (TimeNow() - startTime < timeout && !watchdog.tripped())
+    {
+        scheduler.poll();
+        ++passes;
+
+        // measured wheel speed, in/s
+        float speed = (encoderMonitor.leftVelocity() + encoderMonitor.rightVelocity()) / (2.f * COUNTS_PER_LINEAR_INCH);
+
+        pose = poseEstimator.pose();
+        float error = wrapDegrees(heading - pose.heading);
+        if (!progress.update(std::fabs(error) - HEADING_THRESHOLD))
+            break;
+        if (poseEstimator.fixes() != fixes)
+        {
+            fixes = poseEstimator.fixes();
+            if (-firstDir * error < 90.f)
+                stats.overshoot = std::fmax(stats.overshoot, -firstDir * error);
+        }
+
+        // near 180 degrees out, don't let noise flip which way we're going
+        if (dir * error < -90.f)
+            error += dir * 360.f;
+        if (std::fabs(error) <= HEADING_THRESHOLD / 2.f)
+        {
+            setMotors(0.f, 0.f);
+            dir = 0.f;
+            ++stops;
+            // let the next fix have its say now that we've stopped
+            float stopTime = TimeNow();
+            fixes = poseEstimator.fixes();
+            while (poseEstimator.fixes() == fixes && TimeNow() - stopTime < POSE_FIX_TIMEOUT && !watchdog.tripped())
+                scheduler.poll();
+            pose = poseEstimator.pose();
+            if (std::fabs(wrapDegrees(heading - pose.heading)) <= HEADING_THRESHOLD)
+                break;
+            continue;
+        }
+
+        float rate = std::fmax(TURN_CREEP_RATE, std::fmin(TURN_MAX_RATE, std::sqrt(2.f * TURN_ACCEL * std::fabs(error))));
+        float target = toRadians(rate) * AXLETRACK / 2.f;
+        float extra = TURN_KRATE * (target - speed);
+        dir = std::copysign(1.f, error);
+        if (firstDir == 0.f)
+            firstDir = dir;
+        float left = std::fmax(0.f, std::fabs(motorMap.percent(MotorMap::LEFT, -dir * target)) + extra);
+        float right = std::fmax(0.f, std::fabs(motorMap.percent(MotorMap::RIGHT, dir * target)) + extra);
+        setMotors(-dir * left, dir * right);
+    }
+
+    setMotors(0.f, 0.f);
+    PROFILE_COUNT("headingTurnTo polls", passes);
+    // each stop waits on a fix; more than one means it went round again
+    PROFILE_COUNT("headingTurnTo stops", stops);
+
+    stats.time = TimeNow() - startTime;
+    stats.error = wrapDegrees(heading - pose.heading);
+    return stats;
+}
+
+void turnTo(float heading)
+{
+    headingTurnTo(heading);
+}
+
+void fineMoveInline(float distance, float signedDistance)
+{
+    PROFILE_SCOPE("fineMoveInline");
+    if (watchdog.tripped())
+        return;
+    int pulses = 0;
+    Convergence progress(PULSE_DISTANCE / 2.f);
+    Point starting = rpsToPoint();
+    rpsSettle();
+    float remaining;
+    while ((remaining = distance - pythagoreanDistance(starting, rpsToPoint())) > DISTANCE_THRESHOLD)
+    {
+        if (!progress.update(remaining - DISTANCE_THRESHOLD))
+            break;
+        coarseMoveInline(PULSE_POWER, std::copysign(PULSE_DISTANCE, signedDistance));
+        rpsSettle();
+        ++pulses;
+    }
+    PROFILE_COUNT("fineMoveInline pulses", pulses);
+}
+
+// the old open-loop approach: coarse move, then pulse up to the target.
+// kept around for comparison in BenchModule.
+void pulseMoveInline(float distance)
+{
+    PROFILE_SCOPE("pulseMoveInline");
+    if (watchdog.tripped())
+        return;
+    Point starting = rpsToPoint();
+    coarseMoveInline(40, std::copysign(std::fabs(distance - .75f), distance));
+    rpsSettle();
+    float actualDistance = pythagoreanDistance(starting, rpsToPoint());
+    fineMoveInline(std::fabs(distance) - actualDistance, distance);
+}
+
+static float profileSpeed(float s, float length)
+{
+    // ramp up from creep speed, ramp down to reach creep speed
+    // DRIVE_CREEP_DISTANCE short of the end, then creep the rest
+    float creepStart = std::fmax(0.f, length - DRIVE_CREEP_DISTANCE);
+    float up = std::sqrt(DRIVE_CREEP_SPEED * DRIVE_CREEP_SPEED + 2.f * DRIVE_ACCEL * std::fmax(0.f, s));
+    float down = std::sqrt(DRIVE_CREEP_SPEED * DRIVE_CREEP_SPEED + 2.f * DRIVE_ACCEL * std::fmax(0.f, creepStart - s));
+    return std::fmin(DRIVE_MAX_SPEED, std::fmin(up, down));
+}
+
+static float profileTime(float length)
+{
+    // for the timeout: triangular/trapezoidal time plus the creep
+    float cruise = std::fmax(0.f, length - DRIVE_CREEP_DISTANCE);
+    return 2.f * DRIVE_MAX_SPEED / DRIVE_ACCEL + cruise / DRIVE_MAX_SPEED + 2.f * DRIVE_CREEP_DISTANCE / DRIVE_CREEP_SPEED;
+}
+
+// moves {distance} inches along the current heading in one motion. Follows
+// a trapezoidal speed profile on the encoders (trimming left/right mismatch
+// as it goes), slows to a creep near the end and stops on the pose
+// estimate. Falls back to encoders alone when RPS has never had a fix.
+void profiledMoveInline(float distance)
+{
+    PROFILE_SCOPE("profiledMoveInline");
+    if (watchdog.tripped())
+        return;
+    float length = std::fabs(distance);
+    float dir = std::copysign(1.f, distance);
+
+    Point start = poseEstimator.pose();
+    bool useRps = poseEstimator.valid();
+    float ux = dir * std::cos(toRadians(start.heading));
+    float uy = dir * std::sin(toRadians(start.heading));
+
+    resetEncoders();
+
+    float startTime = TimeNow(), lastTime = startTime;
+    float timeout = profileTime(length) + 2.f;
+    float setpoint = 0.f;
+    int passes = 0;
+
+    while (TimeNow() - startTime < timeout && !watchdog.tripped())
+    {
+        float now = TimeNow();
+        float dt = now - lastTime;
+        lastTime = now;
+
+        scheduler.poll();
+        ++passes;
+
+        float left = hardware().leftEncoder.Counts() / COUNTS_PER_LINEAR_INCH;
+        float right = hardware().rightEncoder.Counts() / COUNTS_PER_LINEAR_INCH;
+        float travelled = (left + right) / 2.f;
+
+        if (useRps && travelled >= length - DRIVE_CREEP_DISTANCE)
+        {
+            Point pt = poseEstimator.pose();
+            float remaining = length - ((pt.x - start.x) * ux + (pt.y - start.y) * uy);
+            if (remaining <= 0.f)
+                break;
+            if (travelled >= length + DRIVE_CREEP_DISTANCE)
+                break;
+        }
+        else if (!useRps && travelled >= length)
+        {
+            break;
+        }
+
+        float speed = profileSpeed(setpoint, length);
+        // don't let the setpoint run away from a wheel that can't keep up
+        setpoint = std::fmin(setpoint + speed * dt, travelled + DRIVE_MAX_LEAD);
+
+        float push = DRIVE_KP * (setpoint - travelled);
+        float trim = DRIVE_KSYNC * (left - right);
+        setMotors(motorMap.percent(MotorMap::LEFT, dir * speed) + dir * (push - trim),
+                  motorMap.percent(MotorMap::RIGHT, dir * speed) + dir * (push + trim));
+    }
+
+    setMotors(0.f, 0.f);
+    PROFILE_COUNT("profiledMoveInline polls", passes);
+}
+
+void moveInline(float distance)
+{
+    profiledMoveInline(distance);
+}
+
+void printPoint(Point pt, bool printHeading)
+{
+    console.write("X:");
+    console.write(pt.x);
+    console.write("\tY:");
+    console.writeLine(pt.y);
+    if (printHeading)
+    {
+        console.write("Heading: ");
+        console.writeLine(pt.heading);
+    }
+}
+
+void printPoint()
+{
+    printPoint(rpsToPoint());
+}
+
+// whichever of pivot-and-drive or an arc gets there sooner
+void moveTo(Point pt)
+{
+    PROFILE_SCOPE("moveTo");
+    runTrajectory(planFastest(poseEstimator.pose(), pt, false), pt);
+}
+
+// as moveTo, but arriving on {pt.heading}; a pair of arcs can do both at once
+void moveToWithTurn(Point pt){
+    PROFILE_SCOPE("moveToWithTurn");
+    runTrajectory(planFastest(poseEstimator.pose(), pt, true), pt);
+}
@@ -0,0 +1,87 @@
+#pragma once
+
+#include "geometry.hpp"
+#include "hardware.hpp"
+
+static constexpr float AXLETRACK = 7.86f;
+static constexpr float WHEELDIAM = 2.41f;
+static constexpr float TURNPERCENT = 30.f;
+// pivots scrub; odometry still uses this, pivotTurn fits its own (turns.hpp)
+static constexpr float CORRECTION_MULTIPLIER = 1.0711f;
+static constexpr float ENCODER_COUNTS_PER_REV = 318.f;
+static constexpr float COUNTS_PER_DEGREE = CORRECTION_MULTIPLIER * countsPerDegree(ENCODER_COUNTS_PER_REV, WHEELDIAM, AXLETRACK);
+
+static constexpr float COUNTS_PER_LINEAR_INCH = countsPerInch(ENCODER_COUNTS_PER_REV, WHEELDIAM);
+
+// what rpsSettle() used to sleep, ms; its statistics are against this
+static constexpr int PULSE_WIDTH = 200;
+// s from an RPS sample to its arrival on the robot
+static constexpr float RPS_LATENCY = .05f;
+
+static constexpr float PULSE_ANGLE = .5f;
+static constexpr float HEADING_THRESHOLD_COARSE = 5.f;
+static constexpr float HEADING_THRESHOLD = 1.f;
+
+static constexpr float PULSE_DISTANCE = .05f;
+static constexpr float DISTANCE_THRESHOLD = .15f;
+static constexpr float PULSE_POWER = 20.f;
+
+// encoder moves give up after this many times as long as they should
+// take, plus this, s
+static constexpr float MOVE_TIMEOUT_FACTOR = 2.f;
+static constexpr float MOVE_TIMEOUT_SLACK = 1.f;
+
+// trapezoidal drive profile, inches and seconds
+static constexpr float DRIVE_MAX_SPEED = 10.f;
+static constexpr float DRIVE_ACCEL = 20.f;
+static constexpr float DRIVE_CREEP_SPEED = 2.f;
+static constexpr float DRIVE_CREEP_DISTANCE = .75f;
+// how far the profile may run ahead of the encoders
+static constexpr float DRIVE_MAX_LEAD = 1.f;
+
+// motor percent = DRIVE_KS + DRIVE_KV * speed (in/s), until motors.txt
+// says otherwise (motors.hpp)
+static constexpr float DRIVE_KS = 8.f;
+static constexpr float DRIVE_KV = 4.6f;
+// percent per inch of position error and of left/right mismatch
+static constexpr float DRIVE_KP = 8.f;
+static constexpr float DRIVE_KSYNC = 10.f;
+
+// heading controller, degrees and seconds
+static constexpr float TURN_MAX_RATE = 150.f;
+static constexpr float TURN_ACCEL = 300.f;
+static constexpr float TURN_CREEP_RATE = 15.f;
+static constexpr float TURN_TIMEOUT = 3.f;
+// percent per in/s of wheel speed error
+static constexpr float TURN_KRATE = 2.f;
+
+struct TurnStats
+{
+    float time;      // s until settled inside HEADING_THRESHOLD
+    float overshoot; // degrees past the target, worst RPS reading
+    float error;     // degrees, last RPS reading
+};
+
+Point rpsToPoint();
+void printPoint(Point pt, bool printHeading = true);
+void printPoint();
+
+void setMotors(float left, float right);
+// wheel surface speeds in in/s, through motorMap
+void setSpeeds(float left, float right);
+void resetEncoders();
+// loads turns.txt and motors.txt, saying on the LCD if one's missing
+void loadDriveCalibration();
+void rpsSettle();
+
+void coarseMoveInline(int percent, float distance);
+void pivotTurn(float degrees, float percent = TURNPERCENT);
+void pulseTurnTo(float heading);
+TurnStats headingTurnTo(float heading);
+void turnTo(float heading);
+void fineMoveInline(float distance, float signedDistance);
+void pulseMoveInline(float distance);
+void profiledMoveInline(float distance);
+void moveInline(float distance);
+void moveTo(Point pt);
+void moveToWithTurn(Point pt);
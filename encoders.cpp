@@ -0,0 +1,187 @@
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "encoders.hpp"
+#include "drive.hpp"
+#include "hardware.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
+
+EncoderMonitor encoderMonitor;
+
+int EncoderMonitor::watch(float counts, float timeout, Callback callback, void *context)
+{
+    for (int i = 0; i < ENCODER_MAX_TARGETS; ++i)
+    {
+        if (_targets[i].pending)
+            continue;
+        float now = TimeNow();
+        _targets[i] = {true, false, counts, now + timeout, callback, context};
+        // it may be there already
+        read(now);
+        check(now);
+        return i;
+    }
+    return -1;
+}
+
+void EncoderMonitor::cancel(int target)
+{
+    if (target >= 0)
+        _targets[target].pending = false;
+}
+
+void EncoderMonitor::cancelAll()
+{
+    for (Target &t : _targets)
+        t.pending = false;
+}
+
+bool EncoderMonitor::wait(int target)
+{
+    if (target < 0)
+        return false;
+    bool approaching = false;
+    while (_targets[target].pending)
+    {
+        if (due(_targets[target]) >= ENCODER_APPROACH)
+        {
+            scheduler.poll();
+            continue;
+        }
+        if (!approaching)
+            ++_approaches;
+        approaching = true;
+        float now = TimeNow();
+        read(now);
+        check(now);
+    }
+    return _targets[target].reached;
+}
+
+bool EncoderMonitor::waitFor(float counts, float timeout, Callback callback, void *context)
+{
+    int target = watch(counts, timeout, callback, context);
+    if (target >= 0)
+        return wait(target);
+
+    ++_full;
+    console.writeLine("Encoder targets full");
+    float deadline = TimeNow() + timeout;
+    bool reached;
+    while (true)
+    {
+        float now = TimeNow();
+        read(now);
+        if ((reached = average() >= counts) || now >= deadline)
+            break;
+        scheduler.poll();
+    }
+    if (reached)
+        ++_reached;
+    else
+        ++_timeouts;
+    if (callback)
+        callback(context);
+    return reached;
+}
+
+void EncoderMonitor::poll(float now)
+{
+    if (_lastRead >= 0.f && now - _lastRead < ENCODER_PERIOD)
+        return;
+    read(now);
+    check(now);
+}
+
+void EncoderMonitor::beforeReset()
+{
+    read(TimeNow());
+}
+
+void EncoderMonitor::afterReset()
+{
+    _leftCounts = _rightCounts = 0;
+}
+
+void EncoderMonitor::read(float now)
+{
+    int left = hardware().leftEncoder.Counts(), right = hardware().rightEncoder.Counts();
+    if (left != _leftCounts || right != _rightCounts)
+        _lastMoved = now;
+    _leftTotal += left - _leftCounts;
+    _rightTotal += right - _rightCounts;
+    _leftCounts = left;
+    _rightCounts = right;
+
+    // the history only takes a sample every ENCODER_PERIOD, however often
+    // wait() reads, so it always spans the window
+    if (_lastRead >= 0.f && now - _lastRead < ENCODER_PERIOD)
+        return;
+    _lastRead = now;
+    _history[_head] = {now, _leftTotal, _rightTotal};
+    _head = (_head + 1) % ENCODER_HISTORY;
+
+    // oldest sample still inside the window
+    const Sample *oldest = nullptr;
+    for (int i = 1; i < ENCODER_HISTORY; ++i)
+    {
+        const Sample &s = _history[(_head - 1 - i + ENCODER_HISTORY) % ENCODER_HISTORY];
+        if (s.time <= 0.f || now - s.time > ENCODER_VELOCITY_WINDOW)
+            break;
+        oldest = &s;
+    }
+    if (!oldest)
+    {
+        _leftVelocity = _rightVelocity = 0.f;
+        return;
+    }
+    float dt = now - oldest->time;
+    _leftVelocity = (_leftTotal - oldest->left) / dt;
+    _rightVelocity = (_rightTotal - oldest->right) / dt;
+}
+
+void EncoderMonitor::check(float now)
+{
+    float counts = average();
+    for (Target &t : _targets)
+    {
+        if (!t.pending)
+            continue;
+        if (counts >= t.counts)
+        {
+            t.reached = true;
+            _lastOvershoot = counts - t.counts;
+            ++_reached;
+            _totalOvershoot += _lastOvershoot;
+            _worstOvershoot = std::fmax(_worstOvershoot, _lastOvershoot);
+        }
+        else if (now >= t.deadline)
+        {
+            ++_timeouts;
+        }
+        else
+        {
+            continue;
+        }
+        t.pending = false;
+        if (t.callback)
+            t.callback(t.context);
+    }
+}
+
+float EncoderMonitor::due(const Target &t) const
+{
+    float remaining = t.counts - average();
+    float velocity = (_leftVelocity + _rightVelocity) / 2.f;
+    if (remaining <= 1.f)
+        return 0.f;
+    return velocity > 0.f ? remaining / velocity : INFINITY;
+}
+
+void EncoderMonitor::write(FEHFile *f) const
+{
+    SD.FPrintf(f, "# encoder targets: reached\ttimed out\tapproaches\tmean overshoot\tworst overshoot (counts)\tno room\n");
+    SD.FPrintf(f, "%d\t%d\t%d\t%f\t%f\t%d\n", _reached, _timeouts, _approaches,
+               _reached ? _totalOvershoot / _reached : 0.f, _worstOvershoot, _full);
+}
@@ -0,0 +1,96 @@
+#pragma once
+
+#include <FEHSD.h>
+
+static constexpr int ENCODER_MAX_TARGETS = 4;
+static constexpr int ENCODER_HISTORY = 16;
+// how often poll() reads the encoders, s
+static constexpr float ENCODER_PERIOD = .002f;
+// s of counts the velocity is taken over
+static constexpr float ENCODER_VELOCITY_WINDOW = .03f;
+// once a target's due within this, s, wait() stops yielding and watches
+// the encoders alone; a poll can take this long (the status overlay)
+static constexpr float ENCODER_APPROACH = .02f;
+
+// Watches the drive encoders from Scheduler::poll() so motion code doesn't
+// have to spin on them. A target fires when the average of the two counts
+// since the last reset reaches it, or when its timeout runs out, and calls
+// its callback from inside whatever poll saw it; a callback that stops the
+// motors stops them there and then, whoever is polling.
+//
+// poll() only reads the encoders every ENCODER_PERIOD. wait() yields to the
+// scheduler until a target is due within ENCODER_APPROACH by the current
+// velocity and then reads nothing but the encoders, so the callback runs
+// within one count of the target.
+class EncoderMonitor
+{
+public:
+    typedef void (*Callback)(void *context);
+
+    // average count to watch for, giving up after {timeout} s; -1 if
+    // there's no room
+    int watch(float counts, float timeout, Callback callback = nullptr, void *context = nullptr);
+    void cancel(int target);
+    void cancelAll();
+    bool pending(int target) const { return target >= 0 && _targets[target].pending; }
+    // yields until the target fires; false if it timed out
+    bool wait(int target);
+    // watch() and wait() in one. With no room for a target it says so and
+    // spins on the encoders itself, rather than skip the move
+    bool waitFor(float counts, float timeout, Callback callback = nullptr, void *context = nullptr);
+    // average count when the last target to be reached fired, less the
+    // target
+    float lastOvershoot() const { return _lastOvershoot; }
+
+    // reads the encoders if it's been ENCODER_PERIOD, and fires targets;
+    // {now} is TimeNow()
+    void poll(float now);
+    // call around resetting the encoders
+    void beforeReset();
+    void afterReset();
+
+    int left() const { return _leftCounts; }
+    int right() const { return _rightCounts; }
+    float average() const { return (_leftCounts + _rightCounts) / 2.f; }
+    // counts/s, by wheel; encoders only count, so never negative
+    float leftVelocity() const { return _leftVelocity; }
+    float rightVelocity() const { return _rightVelocity; }
+    // when either count last changed, by TimeNow(); -1 if never
+    float lastMoved() const { return _lastMoved; }
+
+    // targets reached and timed out, and how far past they fired
+    void write(FEHFile *f) const;
+
+private:
+    struct Target
+    {
+        bool pending, reached;
+        float counts, deadline;
+        Callback callback;
+        void *context;
+    };
+    struct Sample
+    {
+        float time;
+        long left, right; // since start, unaffected by resets
+    };
+
+    Target _targets[ENCODER_MAX_TARGETS] = {};
+    Sample _history[ENCODER_HISTORY] = {};
+    int _head = 0;
+    float _lastRead = -1.f;
+    int _leftCounts = 0, _rightCounts = 0;
+    long _leftTotal = 0, _rightTotal = 0;
+    float _leftVelocity = 0.f, _rightVelocity = 0.f;
+    float _lastMoved = -1.f;
+
+    int _reached = 0, _timeouts = 0, _approaches = 0, _full = 0;
+    float _lastOvershoot = 0.f, _worstOvershoot = 0.f, _totalOvershoot = 0.f;
+
+    void read(float now);
+    void check(float now);
+    // s until the target's reached at the current velocity
+    float due(const Target &t) const;
+};
+
+extern EncoderMonitor encoderMonitor;
@@ -0,0 +1,60 @@
+#!/bin/bash
+# RAM and flash used by the robot's own code, symbol by symbol, from its
+# object files; and a check that none of them calls the heap.
+#   footprint.sh NM RAM_BUDGET FLASH_BUDGET OBJECT...
+# Budgets are bytes, 0 for none. Exits 1 when over budget or when
+# anything allocates.
+
+NM=$1
+RAM_BUDGET=$2
+FLASH_BUDGET=$3
+shift 3
+[ $# -gt 0 ] || { echo "no object files"; exit 1; }
+
+# inline functions and their statics turn up in every object that uses
+# them and the linker keeps one, so weak and unique symbols count once;
+# file-local ones are separate copies, however alike their names
+"$NM" -S -t d --size-sort -C "$@" 2>/dev/null | awk -v ram="$RAM_BUDGET" -v flash="$FLASH_BUDGET" '
+    NF >= 4 {
+        size = $2 + 0
+        name = $4
+        for (i = 5; i <= NF; ++i)
+            name = name " " $i
+        if ($3 ~ /^[WwVvu]$/ && seen[$3 " " name]++)
+            next
+        t = tolower($3)
+        # initialised data takes RAM and its image takes flash
+        if (t == "b" || t == "d" || t == "v" || t == "u" || t == "c") {
+            ramSize[name] += size
+            ramTotal += size
+        }
+        if (t == "t" || t == "r" || t == "w" || t == "d") {
+            flashSize[name] += size
+            flashTotal += size
+        }
+    }
+    function top(title, sizes, cmd) {
+        print "# " title ": bytes\tsymbol"
+        cmd = "sort -rn | head -20"
+        for (s in sizes)
+            print sizes[s] "\t" s | cmd
+        close(cmd)
+    }
+    END {
+        top("RAM", ramSize)
+        top("flash", flashSize)
+        printf "# RAM %d of %s bytes, flash %d of %s\n", ramTotal, ram ? ram : "-", flashTotal, flash ? flash : "-"
+        if ((ram && ramTotal > ram) || (flash && flashTotal > flash)) {
+            print "over budget"
+            exit 1
+        }
+    }' || exit 1
+
+# anything calling new, new[] or malloc, directly or through a container
+HEAP=$("$NM" -uA "$@" 2>/dev/null | grep -E ' (_Zn[wa][jm]|_Zn[wa][jm]RKSt9nothrow_t|malloc|calloc|realloc|strdup)$')
+if [ -n "$HEAP" ]; then
+    echo "heap use:"
+    echo "$HEAP"
+    exit 1
+fi
+echo "# no heap use"
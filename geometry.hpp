@@ -0,0 +1,111 @@
+#pragma once
+
+#include <cmath>
+
+// Plain geometry, no hardware, so host tools can include it too. Headings
+// are degrees counter-clockwise from the course's +x, as RPS gives them.
+
+struct Point
+{
+    float x;
+    float y;
+    float heading;
+};
+
+static constexpr float PI_F = static_cast<float>(M_PI);
+static constexpr float RAD = PI_F / 180.f;
+
+constexpr float toRadians(float degrees) { return degrees * RAD; }
+constexpr float toDegrees(float radians) { return radians / RAD; }
+
+// encoder counts for a wheel of {wheelDiam} to roll an inch
+constexpr float countsPerInch(float countsPerRev, float wheelDiam)
+{
+    return countsPerRev / (PI_F * wheelDiam);
+}
+
+// how far apart the two wheels' counts get per degree turned in place
+constexpr float countsPerDegree(float countsPerRev, float wheelDiam, float axletrack)
+{
+    return countsPerInch(countsPerRev, wheelDiam) * axletrack * RAD;
+}
+
+// wraps to (-180, 180]
+inline float wrapDegrees(float degrees)
+{
+    degrees = std::fmod(degrees, 360.f);
+    if (degrees > 180.f)
+        degrees -= 360.f;
+    else if (degrees <= -180.f)
+        degrees += 360.f;
+    return degrees;
+}
+
+// A heading kept in [0, 360). The difference of two is the shortest signed
+// turn from one to the other, (-180, 180], so a turn worked out from Angles
+// never goes the long way round.
+class Angle
+{
+public:
+    Angle() = default;
+    explicit Angle(float degrees)
+    {
+        _degrees = std::fmod(degrees, 360.f);
+        if (_degrees < 0.f)
+            _degrees += 360.f;
+        // -1e-6 + 360 rounds to 360
+        if (_degrees >= 360.f)
+            _degrees = 0.f;
+    }
+
+    float degrees() const { return _degrees; }
+    float radians() const { return toRadians(_degrees); }
+
+    Angle operator+(float turn) const { return Angle(_degrees + turn); }
+    Angle operator-(float turn) const { return Angle(_degrees - turn); }
+    // the turn that gets from {from} to here
+    float operator-(Angle from) const { return wrapDegrees(_degrees - from._degrees); }
+
+private:
+    float _degrees = 0.f;
+};
+
+// std::atan2 to within .012 degrees, in about half the time (host numbers
+// from sim/tools/geometry_bench.cpp); for loops that run every tick
+inline float fastAtan2(float y, float x)
+{
+    float ax = std::fabs(x), ay = std::fabs(y);
+    float big = std::fmax(ax, ay), small = std::fmin(ax, ay);
+    if (big == 0.f)
+        return 0.f;
+    // odd minimax polynomial for atan on [0, 1]
+    float a = small / big, s = a * a;
+    float r = ((-.0464964749f * s + .15931422f) * s - .327622764f) * s * a + a;
+    if (ay > ax)
+        r = PI_F / 2.f - r;
+    if (x < 0.f)
+        r = PI_F - r;
+    return y < 0.f ? -r : r;
+}
+
+inline float pythagoreanDistance(float x1, float y1, float x2, float y2)
+{
+    return std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
+}
+
+inline float pythagoreanDistance(Point a, Point b)
+{
+    return pythagoreanDistance(a.x, a.y, b.x, b.y);
+}
+
+// bearing from {initial} to {final}, [0, 360)
+inline float getHeadingToPoint(Point initial, Point final)
+{
+    return Angle(toDegrees(fastAtan2(final.y - initial.y, final.x - initial.x))).degrees();
+}
+
+// the turn from {initial}'s heading to face {final}, (-180, 180]
+inline float getChangeInHeading(Point initial, Point final)
+{
+    return Angle(getHeadingToPoint(initial, final)) - Angle(initial.heading);
+}
@@ -0,0 +1,7 @@
+#include "hardware.hpp"
+
+Hardware &hardware()
+{
+    static Hardware hw;
+    return hw;
+}
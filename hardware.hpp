@@ -0,0 +1,22 @@
+#pragma once
+
+#include <FEHIO.h>
+#include <FEHMotor.h>
+#include <FEHServo.h>
+
+// Everything plugged into the Proteus, shared by every module. None of it
+// is constructed until the first call to hardware(), which main() makes
+// once a module has been picked, so setting up pins and PWM doesn't hold
+// up the menu.
+struct Hardware
+{
+    FEHMotor leftMotor{FEHMotor::Motor0, 9};
+    FEHMotor rightMotor{FEHMotor::Motor3, 9};
+    DigitalEncoder leftEncoder{FEHIO::P1_0};
+    DigitalEncoder rightEncoder{FEHIO::P1_7};
+    FEHServo armServo{FEHServo::Servo0};
+    FEHServo wheelServo{FEHServo::Servo7};
+    AnalogInputPin cds{FEHIO::P0_0};
+};
+
+Hardware &hardware();
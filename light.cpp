@@ -0,0 +1,94 @@
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "light.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+
+static const float colorDrops[] = {0.f, LIGHT_RED_DROP, LIGHT_BLUE_DROP};
+
+const char *lightName(LightColor color)
+{
+    static const char *const names[] = {"none", "red", "blue"};
+    return names[color];
+}
+
+float LightSensor::sample()
+{
+    float sum = 0.f;
+    for (int i = 0; i < LIGHT_OVERSAMPLE; ++i)
+        sum += _pin.Value();
+    return sum / LIGHT_OVERSAMPLE;
+}
+
+void LightSensor::track(float v)
+{
+    if (std::fabs(v - _ambient) < LIGHT_AMBIENT_BAND * _ambient)
+        _ambient += LIGHT_AMBIENT_RATE * (v - _ambient);
+}
+
+void LightSensor::waitForStart()
+{
+    PROFILE_SCOPE("waitForStart");
+    int run = 0;
+    while (run < LIGHT_START_CONFIRM)
+    {
+        scheduler.poll();
+        float now = TimeNow();
+        float v = sample();
+        if (_ambient - v > LIGHT_START_DROP * _ambient || std::fabs(v - LIGHT_START_RED) < LIGHT_START_MARGIN)
+        {
+            if (run++ == 0)
+                _edge = now;
+            continue;
+        }
+        run = 0;
+        track(v);
+    }
+    _detected = TimeNow();
+}
+
+LightReading LightSensor::classify(float timeout)
+{
+    PROFILE_SCOPE("classifyLight");
+    LightReading r = {LIGHT_NONE, 0.f, 0.f, 0, 0.f};
+    float start = TimeNow();
+    float base = ambient();
+    // running mean and sum of squared differences of the drop
+    float mean = 0.f, squares = 0.f;
+
+    while (true)
+    {
+        float drop = (base - sample()) / base;
+        ++r.samples;
+        float delta = drop - mean;
+        mean += delta / r.samples;
+        squares += delta * (drop - mean);
+
+        // nearest colour, and how far the mean is from the boundary with
+        // its nearest neighbour in standard errors
+        int best = 0;
+        for (int c = 1; c < 3; ++c)
+        {
+            if (std::fabs(mean - colorDrops[c]) < std::fabs(mean - colorDrops[best]))
+                best = c;
+        }
+        float margin = INFINITY;
+        for (int c = 0; c < 3; ++c)
+        {
+            if (c != best)
+                margin = std::fmin(margin, std::fabs(mean - (colorDrops[c] + colorDrops[best]) / 2.f));
+        }
+        float sd = r.samples > 1 ? std::sqrt(squares / (r.samples - 1)) : 0.f;
+        sd = std::fmax(sd, LIGHT_MIN_NOISE / base);
+        float z = margin / (sd / std::sqrt(static_cast<float>(r.samples)));
+
+        r.color = static_cast<LightColor>(best);
+        r.confidence = .5f * std::erfc(-z / std::sqrt(2.f));
+        r.drop = mean;
+        r.time = TimeNow() - start;
+        if ((r.samples >= LIGHT_MIN_SAMPLES && r.confidence >= LIGHT_CONFIDENCE) || r.time >= timeout)
+            return r;
+        scheduler.poll();
+    }
+}
@@ -0,0 +1,77 @@
+#pragma once
+
+#include <FEHIO.h>
+
+// ADC reads averaged into one sample
+static constexpr int LIGHT_OVERSAMPLE = 4;
+// how much of each sample the ambient baseline takes on...
+static constexpr float LIGHT_AMBIENT_RATE = .02f;
+// ...as long as it's within this share of the baseline
+static constexpr float LIGHT_AMBIENT_BAND = .1f;
+// the start light has to take this share off the baseline, for this many
+// samples in a row
+static constexpr float LIGHT_START_DROP = .3f;
+static constexpr int LIGHT_START_CONFIRM = 3;
+// share of the ambient reading each colour takes off
+static constexpr float LIGHT_RED_DROP = (3.07f - .29f) / 3.07f;
+static constexpr float LIGHT_BLUE_DROP = (3.07f - 1.85f) / 3.07f;
+// what ambient reads before we've seen any, V; the baseline starts here
+static constexpr float LIGHT_AMBIENT = 3.07f;
+// a reading in this window is the start light whatever the baseline, V
+static constexpr float LIGHT_START_RED = .5f;
+static constexpr float LIGHT_START_MARGIN = .4f;
+// classify() stops once it's this sure, with at least this many samples
+static constexpr float LIGHT_CONFIDENCE = .999f;
+static constexpr int LIGHT_MIN_SAMPLES = 3;
+// V; the least noise assumed, so a few equal samples aren't certainty
+static constexpr float LIGHT_MIN_NOISE = .01f;
+
+enum LightColor { LIGHT_NONE, LIGHT_RED, LIGHT_BLUE };
+
+struct LightReading
+{
+    LightColor color;
+    float confidence; // 0-1
+    float drop;       // mean share of ambient taken off
+    int samples;
+    float time;       // s it took
+};
+
+// The CdS cell, as something that answers questions. Each sample averages
+// a few ADC reads; an ambient baseline follows slow changes in the room
+// (but not lights coming on) so both questions are asked relative to it.
+// It starts from LIGHT_AMBIENT rather than the first sample, so a start
+// light that's already on when we're armed is still a drop, and a reading
+// in the absolute red window counts as the light too. waitForStart()
+// needs LIGHT_START_CONFIRM samples past the threshold in a row, which
+// bounds both its latency and how easily noise sets it off.
+// classify() keeps sampling until the mean is far enough from the nearest
+// colour boundary, in standard errors, to be LIGHT_CONFIDENCE sure.
+class LightSensor
+{
+public:
+    explicit LightSensor(AnalogInputPin &pin) : _pin(pin) {}
+
+    // one oversampled reading, V
+    float sample();
+    float ambient() const { return _ambient; }
+
+    // tracks ambient until the start light comes on
+    void waitForStart();
+    // when the first of the confirming samples was taken, and when we
+    // were sure, by TimeNow()
+    float startEdge() const { return _edge; }
+    float startDetected() const { return _detected; }
+
+    // red, blue or nothing, giving up after {timeout} s
+    LightReading classify(float timeout);
+
+private:
+    AnalogInputPin &_pin;
+    float _ambient = LIGHT_AMBIENT;
+    float _edge = 0.f, _detected = 0.f;
+
+    void track(float v);
+};
+
+const char *lightName(LightColor color);
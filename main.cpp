@@ -1,37 +1,97 @@
 #include <FEHLCD.h>
-#include <vector>
+#include <FEHSD.h>
+#include <FEHUtility.h>
 #include <cstring>
+#include "boot.hpp"
+#include "hardware.hpp"
 #include "module.hpp"
+#include "status.hpp"
 
 extern "C" size_t strlcpy(char *dst, const char *src, size_t dsize);
 
-int main() {
-    size_t nmodules = module_provider.vec().size();
-
+// the menu, until something's pressed; the index of what was. {shown} is
+// when it came up, if nothing came up before it
+static int menu(float &shown) {
     FEHIcon::Icon icons[nmodules];
     char labels[nmodules][20];
     for (int i = 0; i < nmodules; ++i) {
-        strlcpy(labels[i], module_provider.vec()[i]->name().c_str(), 20);
+        strlcpy(labels[i], modules[i]->name(), 20);
     }
-    LCD.Clear();
+    console.clear();
     FEHIcon::DrawIconArray(icons, nmodules, 1, 0, 1, 1, 1, labels, 0xFFFFFF, 0xFFFFFF);
+    if (shown < 0.f)
+        shown = TimeNow();
 
     float x, y;
-    int idx;
-
     while (true) {
         LCD.Touch(&x, &y);
         for (int i = 0; i < nmodules; ++i) {
             if (icons[i].Pressed(x, y, 0)) {
                 icons[i].WhilePressed(x, y);
                 icons[i].Deselect();
-                idx = i;
-                goto run;
+                return i;
+            }
+        }
+    }
+}
+
+// s it took
+static float startHardware() {
+    float start = TimeNow();
+    hardware();
+    return TimeNow() - start;
+}
+
+int main() {
+    FEHFile *config = SD.FOpen(BOOT_CONFIG, "r");
+    if (config) {
+        if (!loadBootConfig(config, bootConfig))
+            console.writeLine("autorun.txt has a bad line, ignoring the rest");
+        SD.FClose(config);
+    }
+
+    int idx = findModule(bootConfig.module), prepared = -1, ret = 0;
+    bool autorun = idx >= 0;
+    // from power on, everything before main() included, to the banner or
+    // the menu
+    float shown = -1.f, hardwareTime = -1.f;
+    if (autorun) {
+        console.clear();
+        console.write("Running ");
+        console.writeLine(modules[idx]->name());
+        console.writeLine("Touch for the menu");
+        shown = TimeNow();
+
+        // the slow parts of starting up go in the window, not after it
+        hardwareTime = startHardware();
+        ret = modules[idx]->prepare();
+        prepared = idx;
+
+        float x, y;
+        while (TimeNow() - shown < bootConfig.window) {
+            if (LCD.Touch(&x, &y)) {
+                autorun = false;
+                // or the menu would take it as a press
+                while (LCD.Touch(&x, &y));
+                break;
             }
         }
     }
 
-run:
-    LCD.Clear();
-    return module_provider.vec()[idx]->run();
+    if (!autorun) {
+        idx = menu(shown);
+        console.clear();
+    }
+    if (hardwareTime < 0.f)
+        hardwareTime = startHardware();
+    if (prepared != idx)
+        ret = modules[idx]->prepare();
+
+    FEHFile *boot = SD.FOpen("boot.txt", "w");
+    SD.FPrintf(boot, "# boot to menu\thardware start\tmodules\tpicked\tautorun\tboot to run\n");
+    SD.FPrintf(boot, "%f\t%f\t%d\t%s\t%d\t%f\n", shown, hardwareTime, static_cast<int>(nmodules),
+               modules[idx]->name(), autorun, TimeNow());
+    SD.FClose(boot);
+
+    return ret ? ret : modules[idx]->run();
 }
\ No newline at end of file
@@ -0,0 +1,243 @@
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <FEHUtility.h>
+
+#include "mission.hpp"
+#include "module.hpp"
+#include "pose.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+#include "telemetry.hpp"
+#include "trajectory.hpp"
+
+static int promptIndex(const char *token)
+{
+    if (std::strcmp(token, "lever") == 0)
+        return MISSION_LEVER;
+    for (size_t i = 0; i < nprompts; ++i)
+    {
+        if (nameMatches(prompts[i], token))
+            return i;
+    }
+    return -2;
+}
+
+bool loadMission(FEHFile *file, Mission &mission)
+{
+    if (!file)
+        return false;
+
+    Mission m = {};
+    char after[MISSION_MAX_TASKS][MISSION_NAME_LEN];
+    MissionTask t;
+    while (m.count < MISSION_MAX_TASKS &&
+           SD.FScanf(file, "%15s%f%15s%f%f%d", t.name, &t.duration, after[m.count], &t.delay, &t.deadline, &t.npoints) == 6)
+    {
+        if (t.npoints < 1 || t.npoints > ROUTE_MAX_POINTS)
+            return false;
+        for (int i = 0; i < t.npoints; ++i)
+        {
+            char token[32];
+            if (SD.FScanf(file, "%31s", token) != 1 || (t.points[i] = promptIndex(token)) == -2)
+                return false;
+        }
+        m.tasks[m.count++] = t;
+    }
+    if (m.count == 0)
+        return false;
+
+    // constraints name earlier or later tasks; resolve them once all are in
+    for (int i = 0; i < m.count; ++i)
+    {
+        m.tasks[i].after = -1;
+        if (std::strcmp(after[i], "-") == 0)
+            continue;
+        for (int j = 0; j < m.count; ++j)
+        {
+            if (j != i && std::strcmp(after[i], m.tasks[j].name) == 0)
+                m.tasks[i].after = j;
+        }
+        if (m.tasks[i].after < 0)
+            return false;
+    }
+
+    mission = m;
+    return true;
+}
+
+float routeTime(Point from, const Point *points, int n)
+{
+    float t = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        t += planFastest(from, points[i], i == n - 1).time;
+        from = points[i];
+    }
+    return t;
+}
+
+void resolveRoutes(const Mission &mission, const Point *points, int lever, MissionRoutes &routes)
+{
+    for (int i = 0; i < mission.count; ++i)
+    {
+        const MissionTask &t = mission.tasks[i];
+        for (int j = 0; j < t.npoints; ++j)
+            routes[i][j] = points[t.points[j] == MISSION_LEVER ? lever : t.points[j]];
+    }
+}
+
+static Point routeEnd(const Mission &mission, const MissionRoutes &routes, int task)
+{
+    return routes[task][mission.tasks[task].npoints - 1];
+}
+
+MissionPlan planMission(const Mission &mission, const MissionRoutes &routes, Point start, Point home)
+{
+    int n = mission.count;
+
+    // what it costs to get to each task from anywhere
+    float fromStart[MISSION_MAX_TASKS], toHome[MISSION_MAX_TASKS];
+    float travel[MISSION_MAX_TASKS][MISSION_MAX_TASKS];
+    for (int i = 0; i < n; ++i)
+    {
+        Point end = routeEnd(mission, routes, i);
+        fromStart[i] = routeTime(start, routes[i], mission.tasks[i].npoints);
+        toHome[i] = routeTime(end, &home, 1);
+        for (int j = 0; j < n; ++j)
+            travel[i][j] = routeTime(end, routes[j], mission.tasks[j].npoints);
+    }
+
+    MissionPlan best = {};
+    best.time = INFINITY;
+    // the file's order, should none meet the constraints
+    int order[MISSION_MAX_TASKS];
+    for (int i = 0; i < n; ++i)
+        order[i] = best.order[i] = i;
+    do
+    {
+        MissionPlan plan = {};
+        float finish[MISSION_MAX_TASKS];
+        bool done[MISSION_MAX_TASKS] = {};
+        float t = 0.f;
+        bool ok = true;
+        for (int k = 0; k < n && ok; ++k)
+        {
+            const MissionTask &task = mission.tasks[order[k]];
+            t += k == 0 ? fromStart[order[k]] : travel[order[k - 1]][order[k]];
+            if (task.after >= 0)
+            {
+                ok = done[task.after];
+                t = std::max(t, finish[task.after] + task.delay);
+            }
+            plan.start[order[k]] = t;
+            t += task.duration;
+            finish[order[k]] = t;
+            done[order[k]] = true;
+            if (task.deadline > 0.f && t > task.deadline)
+                ok = false;
+        }
+        if (!ok)
+            continue;
+        plan.time = t + toHome[order[n - 1]];
+        if (plan.time < best.time)
+        {
+            std::copy(order, order + n, plan.order);
+            best = plan;
+        }
+    } while (std::next_permutation(order, order + n));
+
+    return best;
+}
+
+float runMission(const Mission &mission, const MissionPlan &plan, const MissionRoutes &routes,
+                 MissionRunner &runner, FEHFile *log)
+{
+    int n = mission.count;
+    float start = TimeNow();
+    float finish[MISSION_MAX_TASKS];
+    bool done[MISSION_MAX_TASKS] = {};
+    // the window in front of each task when we first filled it
+    float window[MISSION_MAX_TASKS] = {};
+    float saved = 0.f;
+
+    auto travelTime = [&](int task) {
+        return routeTime(poseEstimator.pose(), routes[task], mission.tasks[task].npoints);
+    };
+    auto runnable = [&](int task) {
+        int after = mission.tasks[task].after;
+        return !done[task] && (after < 0 || done[after]);
+    };
+    auto earliest = [&](int task) {
+        const MissionTask &t = mission.tasks[task];
+        return t.after < 0 ? 0.f : finish[t.after] + t.delay;
+    };
+
+    SD.FPrintf(log, "# task\tstart\twindow\twait\tsaved\n");
+    for (int remaining = n; remaining > 0; --remaining)
+    {
+        float now = TimeNow() - start;
+
+        // the plan's next task, unless something else is up against its deadline
+        int next = -1;
+        for (int k = 0; k < n && next < 0; ++k)
+        {
+            if (runnable(plan.order[k]))
+                next = plan.order[k];
+        }
+        for (int i = 0; i < n; ++i)
+        {
+            const MissionTask &t = mission.tasks[i];
+            if (runnable(i) && t.deadline > 0.f && now + travelTime(i) + t.duration + MISSION_MARGIN >= t.deadline &&
+                (mission.tasks[next].deadline <= 0.f || t.deadline < mission.tasks[next].deadline))
+                next = i;
+        }
+        if (next < 0)
+            break;
+
+        // if it'd have to wait, do whatever fits in the meantime instead
+        float direct = travelTime(next);
+        float slack = earliest(next) - (now + direct);
+        int fill = -1;
+        if (slack >= MISSION_MIN_FILL)
+        {
+            float longest = 0.f;
+            for (int i = 0; i < n; ++i)
+            {
+                if (i == next || !runnable(i))
+                    continue;
+                const MissionTask &t = mission.tasks[i];
+                float there = travelTime(i);
+                float cost = there + t.duration + routeTime(routeEnd(mission, routes, i), routes[next], mission.tasks[next].npoints) - direct;
+                if (earliest(i) <= now + there && cost + MISSION_MARGIN <= slack && t.duration > longest)
+                {
+                    fill = i;
+                    longest = t.duration;
+                }
+            }
+        }
+        if (fill >= 0 && window[next] <= 0.f)
+            window[next] = slack;
+        int task = fill >= 0 ? fill : next;
+
+        runner.travel(task);
+        float arrived = TimeNow() - start;
+        telemetry.flush();
+        {
+            PROFILE_SCOPE("constraint wait");
+            while (TimeNow() - start < earliest(task))
+                scheduler.poll();
+        }
+        float begin = TimeNow() - start;
+        float wait = begin - arrived;
+        runner.perform(task);
+        finish[task] = TimeNow() - start;
+        done[task] = true;
+
+        float taskSaved = std::max(0.f, window[task] - wait);
+        saved += taskSaved;
+        SD.FPrintf(log, "%s\t%f\t%f\t%f\t%f\n", mission.tasks[task].name, begin, window[task], wait, taskSaved);
+    }
+    SD.FPrintf(log, "# idle time eliminated: %f s\n", saved);
+    return saved;
+}
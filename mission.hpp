@@ -0,0 +1,80 @@
+#pragma once
+
+#include <FEHSD.h>
+
+#include "drive.hpp"
+#include "route.hpp"
+
+static constexpr int MISSION_MAX_TASKS = 8;
+static constexpr int MISSION_NAME_LEN = 16;
+// stands in for whichever "Behind lever N" RPS picks
+static constexpr int MISSION_LEVER = -1;
+// windows shorter than this, s, aren't worth filling
+static constexpr float MISSION_MIN_FILL = 1.f;
+// s of margin kept on deadlines and fills, for estimates that run long
+static constexpr float MISSION_MARGIN = 1.f;
+
+// One line of the plan:
+//   name duration after delay deadline npoints point...
+// {duration} is how long the task takes once it's at its last point,
+// {after}/{delay} say it can't start until {delay} s after task {after}
+// finished ("-" for none), {deadline} is when it has to be done by, s
+// after setting off (0 for none), and the points are the route there, as
+// prompts with underscores for spaces, or "lever".
+struct MissionTask
+{
+    char name[MISSION_NAME_LEN];
+    float duration;
+    int after; // index into the mission, or -1
+    float delay;
+    float deadline;
+    int npoints;
+    int points[ROUTE_MAX_POINTS]; // prompt index, or MISSION_LEVER
+};
+
+struct Mission
+{
+    MissionTask tasks[MISSION_MAX_TASKS];
+    int count;
+};
+
+// each task's route with the prompts looked up
+typedef Point MissionRoutes[MISSION_MAX_TASKS][ROUTE_MAX_POINTS];
+
+struct MissionPlan
+{
+    int order[MISSION_MAX_TASKS];
+    float start[MISSION_MAX_TASKS]; // s after setting off, indexed by task
+    float time;                     // s to finish everything and get home
+};
+
+// what the executor needs from the course
+class MissionRunner
+{
+public:
+    virtual ~MissionRunner() {}
+    // get ready for and drive to {task}
+    virtual void travel(int task) = 0;
+    // do {task}, once there
+    virtual void perform(int task) = 0;
+};
+
+// false, and {mission} untouched, if {file} is missing or malformed
+bool loadMission(FEHFile *file, Mission &mission);
+
+// {points} are the calibrated prompts, {lever} the prompt RPS chose
+void resolveRoutes(const Mission &mission, const Point *points, int lever, MissionRoutes &routes);
+
+// travel estimate from {from} along {n} points
+float routeTime(Point from, const Point *points, int n);
+
+// tries every order that meets the constraints and keeps the quickest;
+// the file's order if none does
+MissionPlan planMission(const Mission &mission, const MissionRoutes &routes, Point start, Point home);
+
+// runs {plan}, but when the next task has to wait for its constraint,
+// first runs whatever else fits in the window, taking tasks close to their
+// deadline out of turn. Logs each task's window, wait and the idle time
+// filling saved to {log}; returns the total saved.
+float runMission(const Mission &mission, const MissionPlan &plan, const MissionRoutes &routes,
+                 MissionRunner &runner, FEHFile *log);
@@ -1,20 +1,21 @@
 #include <module.hpp>
 
-ModuleProvider &ModuleProvider::instance() {
-    static ModuleProvider inst;
-    return inst;
-}
-
-void ModuleProvider::register_module(std::unique_ptr<Module> &&fac) {
-    _vec.emplace_back(std::move(fac));
-}
+RunCourseModule runCourseModule;
+CalibrationModule calibrationModule;
+CDSModule cdsModule;
+BenchModule benchModule;
+MotorModule motorModule;
 
-ModuleProvider::ModuleProvider() {
-    register_module(std::make_unique<RunCourseModule>());
-    register_module(std::make_unique<CalibrationModule>());
-    register_module(std::make_unique<CDSModule>());
+bool nameMatches(const char *name, const char *token) {
+    while (*name && (*name == *token || (*name == ' ' && *token == '_')))
+        ++name, ++token;
+    return !*name && !*token;
 }
 
-const std::vector<std::unique_ptr<Module>> &ModuleProvider::vec() {
-    return _vec;
+int findModule(const char *token) {
+    for (size_t i = 0; i < nmodules; ++i) {
+        if (nameMatches(modules[i]->name(), token))
+            return i;
+    }
+    return -1;
 }
\ No newline at end of file
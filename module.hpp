@@ -1,8 +1,21 @@
-#include <vector>
-#include <string>
-#include <memory>
+#pragma once
 
-static const std::vector<const char*> prompts = {
+#include <cstddef>
+
+// the calibrated points, in the order CalibrationModule asks for them
+enum Waypoint {
+    BOTTOM_OF_RAMP,
+    TOP_OF_RAMP,
+    BEHIND_LEVER_0,
+    BEHIND_LEVER_1,
+    BEHIND_LEVER_2,
+    BEHIND_BURGER_FLIP,
+    BEHIND_JUKEBOX_LIGHT,
+    WAYPOINT_COUNT
+};
+
+// what CalibrationModule asks for, and mission.txt's names, by Waypoint
+inline constexpr const char *prompts[] = {
     "Bottom of ramp",
     "Top of ramp",
     "Behind lever 0",
@@ -12,46 +25,75 @@ static const std::vector<const char*> prompts = {
     "Behind jukebox light"
 };
 
-static const size_t nprompts = prompts.size();
+static constexpr size_t nprompts = sizeof prompts / sizeof prompts[0];
+static_assert(nprompts == WAYPOINT_COUNT, "every waypoint needs a prompt");
 
-class ModuleProvider;
+// whether {token}, off SD, names {name}: config files can't have spaces,
+// so they're written as underscores
+bool nameMatches(const char *name, const char *token);
 
 class Module {
 protected:
-    friend ModuleProvider;
-    Module() {}
+    constexpr Module() {}
 public:
     virtual ~Module() {}
-    virtual const std::string &name() const = 0;
+    virtual const char *name() const = 0;
+    // reads whatever run() needs off SD without moving anything, so main()
+    // can do it while the autorun banner is up; nonzero is what main()
+    // should return
+    virtual int prepare() { return 0; }
     virtual int run() = 0;
 };
 
-class ModuleProvider {
-private:
-    ModuleProvider();
-    std::vector<std::unique_ptr<Module>> _vec;
-    void register_module(std::unique_ptr<Module>&&);
+class RunCourseModule : public Module {
 public:
-    static ModuleProvider &instance();
-    const std::vector<std::unique_ptr<Module>> &vec();
+    const char *name() const;
+    int prepare();
+    int run();
 };
 
-static ModuleProvider &module_provider = ModuleProvider::instance();
+class CalibrationModule : public Module {
+public:
+    const char *name() const;
+    int run();
+};
 
-class RunCourseModule : public Module {
+class CDSModule : public Module {
 public:
-    const std::string &name() const;
+    const char *name() const;
     int run();
 };
 
-class CalibrationModule : public Module {
+class BenchModule : public Module {
 public:
-    const std::string &name() const;
+    const char *name() const;
     int run();
 };
 
-class CDSModule : public Module {
+class MotorModule : public Module {
 public:
-    const std::string &name() const;
+    const char *name() const;
     int run();
-};
\ No newline at end of file
+};
+
+// defined in module.cpp; constant-initialised, so there's nothing to run
+// before main()
+extern RunCourseModule runCourseModule;
+extern CalibrationModule calibrationModule;
+extern CDSModule cdsModule;
+extern BenchModule benchModule;
+extern MotorModule motorModule;
+
+// the menu, in order; a new module goes here and nowhere else
+inline constexpr Module *const modules[] = {
+    &runCourseModule,
+    &calibrationModule,
+    &cdsModule,
+    &benchModule,
+    &motorModule
+};
+
+static constexpr size_t nmodules = sizeof modules / sizeof modules[0];
+
+// index into modules of the one {token} names, or -1
+int findModule(const char *token);
\ No newline at end of file
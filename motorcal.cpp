@@ -0,0 +1,78 @@
+#include <FEHLCD.h>
+#include <FEHRPS.h>
+#include <FEHSD.h>
+#include <FEHUtility.h>
+
+#include "module.hpp"
+#include "drive.hpp"
+#include "motors.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
+
+const char *MotorModule::name() const {
+    return "Motor map";
+}
+
+// spins in place at {percent}, counterclockwise for spin 1, and measures
+// both wheels' steady speed in in/s
+static void spin(float spin, float percent, float &left, float &right) {
+    setMotors(-spin * percent, spin * percent);
+    scheduler.wait(MOTOR_SETTLE);
+    int left0 = hardware().leftEncoder.Counts(), right0 = hardware().rightEncoder.Counts();
+    float start = TimeNow();
+    scheduler.wait(MOTOR_WINDOW);
+    float elapsed = TimeNow() - start;
+    left = (hardware().leftEncoder.Counts() - left0) / (COUNTS_PER_LINEAR_INCH * elapsed);
+    right = (hardware().rightEncoder.Counts() - right0) / (COUNTS_PER_LINEAR_INCH * elapsed);
+    setMotors(0.f, 0.f);
+    scheduler.wait(MOTOR_SETTLE);
+}
+
+// Steps both motors through the sweep, spinning in place each way so it
+// needs no room and ends up facing about where it started, and fits each
+// side's forward and reverse curves. Spinning loads the wheels a little
+// differently from driving straight; the drive loops' feedback takes up
+// the rest. The raw sweep goes to motorsweep.txt, the curves to motors.txt.
+int MotorModule::run() {
+    RPS.InitializeTouchMenu();
+    resetEncoders();
+
+    FEHFile *f = SD.FOpen("motorsweep.txt", "w");
+    SD.FPrintf(f, "# percent\tleft fwd\tleft rev\tright fwd\tright rev (in/s)\n");
+
+    // side, reverse
+    float percents[MOTOR_SWEEP_STEPS], speeds[2][2][MOTOR_SWEEP_STEPS];
+    for (int i = 0; i < MOTOR_SWEEP_STEPS; ++i) {
+        float percent = MOTOR_SWEEP_MIN + i * MOTOR_SWEEP_STEP;
+        percents[i] = percent;
+        status.set("percent", percent);
+        // counterclockwise runs the left wheel backwards and the right forwards
+        spin(1.f, percent, speeds[MotorMap::LEFT][1][i], speeds[MotorMap::RIGHT][0][i]);
+        spin(-1.f, percent, speeds[MotorMap::LEFT][0][i], speeds[MotorMap::RIGHT][1][i]);
+        SD.FPrintf(f, "%f\t%f\t%f\t%f\t%f\n", percent, speeds[0][0][i], speeds[0][1][i], speeds[1][0][i], speeds[1][1][i]);
+    }
+    SD.FClose(f);
+
+    console.clear();
+    console.writeLine("side dir deadband kv rms");
+    for (int side = MotorMap::LEFT; side <= MotorMap::RIGHT; ++side) {
+        for (int reverse = 0; reverse < 2; ++reverse) {
+            MotorMap::Curve &c = motorMap.curve(side, reverse ? -1.f : 1.f);
+            c = MotorMap::fit(percents, speeds[side][reverse], MOTOR_SWEEP_STEPS);
+            console.write(side == MotorMap::LEFT ? "L " : "R ");
+            console.write(reverse ? "rev " : "fwd ");
+            console.write(c.ks);
+            console.write(" ");
+            console.write(c.kv);
+            console.write(" ");
+            console.writeLine(c.rms);
+        }
+    }
+
+    f = SD.FOpen("motors.txt", "w");
+    motorMap.save(f);
+    SD.FClose(f);
+
+    console.writeLine("Goodbye.");
+    return 0;
+}
@@ -0,0 +1,106 @@
+#include <cmath>
+
+#include "motors.hpp"
+#include "drive.hpp"
+
+MotorMap motorMap;
+
+void MotorMap::reset()
+{
+    for (auto &side : _curves)
+    {
+        for (Curve &c : side)
+            c = {DRIVE_KS, DRIVE_KV, 0.f, 0};
+    }
+}
+
+bool MotorMap::load(FEHFile *f)
+{
+    reset();
+    if (!f)
+        return false;
+    int side, dir, loaded = 0;
+    Curve c;
+    while (SD.FScanf(f, "%d%d%f%f%f%d", &side, &dir, &c.ks, &c.kv, &c.rms, &c.samples) == 6)
+    {
+        if ((side == LEFT || side == RIGHT) && c.kv > 0.f)
+        {
+            curve(side, dir) = c;
+            ++loaded;
+        }
+    }
+    return loaded > 0;
+}
+
+void MotorMap::save(FEHFile *f) const
+{
+    for (int side = LEFT; side <= RIGHT; ++side)
+    {
+        for (int dir = 1; dir >= -1; dir -= 2)
+        {
+            const Curve &c = curve(side, dir);
+            SD.FPrintf(f, "%d\t%d\t%f\t%f\t%f\t%d\n", side, dir, c.ks, c.kv, c.rms, c.samples);
+        }
+    }
+}
+
+float MotorMap::percent(int side, float speed) const
+{
+    if (speed == 0.f)
+        return 0.f;
+    const Curve &c = curve(side, speed);
+    return std::copysign(c.ks + c.kv * std::fabs(speed), speed);
+}
+
+float MotorMap::speed(int side, float percent) const
+{
+    const Curve &c = curve(side, percent);
+    return std::copysign(std::fmax(0.f, (std::fabs(percent) - c.ks) / c.kv), percent);
+}
+
+float MotorMap::nominalSpeed(float percent) const
+{
+    return (speed(LEFT, percent) + speed(RIGHT, percent)) / 2.f;
+}
+
+MotorMap::Curve MotorMap::fit(const float *percent, const float *speed, int n)
+{
+    Curve c = {DRIVE_KS, DRIVE_KV, 0.f, 0};
+    float meanSpeed = 0.f, meanPercent = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        if (speed[i] < MOTOR_MIN_SPEED)
+            continue;
+        meanSpeed += speed[i];
+        meanPercent += percent[i];
+        ++c.samples;
+    }
+    if (c.samples < 2)
+        return c;
+    meanSpeed /= c.samples;
+    meanPercent /= c.samples;
+
+    float covariance = 0.f, variance = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        if (speed[i] < MOTOR_MIN_SPEED)
+            continue;
+        covariance += (speed[i] - meanSpeed) * (percent[i] - meanPercent);
+        variance += (speed[i] - meanSpeed) * (speed[i] - meanSpeed);
+    }
+    if (variance <= 0.f || covariance <= 0.f)
+        return c;
+    c.kv = covariance / variance;
+    c.ks = meanPercent - c.kv * meanSpeed;
+
+    float squares = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        if (speed[i] < MOTOR_MIN_SPEED)
+            continue;
+        float residual = percent[i] - (c.ks + c.kv * speed[i]);
+        squares += residual * residual;
+    }
+    c.rms = std::sqrt(squares / c.samples);
+    return c;
+}
@@ -0,0 +1,55 @@
+#pragma once
+
+#include <FEHSD.h>
+
+// the characterization sweep in MotorModule: spins in place at each
+// percent, letting the wheels settle and then timing them
+static constexpr float MOTOR_SWEEP_MIN = 4.f;
+static constexpr float MOTOR_SWEEP_MAX = 84.f;
+static constexpr float MOTOR_SWEEP_STEP = 8.f;
+static constexpr int MOTOR_SWEEP_STEPS = static_cast<int>((MOTOR_SWEEP_MAX - MOTOR_SWEEP_MIN) / MOTOR_SWEEP_STEP) + 1;
+static constexpr float MOTOR_SETTLE = .4f;
+static constexpr float MOTOR_WINDOW = .5f;
+// in/s; anything slower is taken as stalled in the deadband
+static constexpr float MOTOR_MIN_SPEED = .3f;
+
+// What motor percent gives what wheel surface speed, per side and
+// direction: percent = ks + kv * speed above the deadband ks. Fitted by
+// MotorModule and kept in motors.txt; without it both sides use DRIVE_KS
+// and DRIVE_KV. The drive primitives ask for speeds in in/s and let this
+// pick each side's percent, so a weak side gets what it needs to keep up.
+class MotorMap
+{
+public:
+    enum Side { LEFT, RIGHT };
+    struct Curve
+    {
+        float ks, kv;
+        float rms; // percent, what the fit left over
+        int samples;
+    };
+
+    MotorMap() { reset(); }
+    void reset();
+    bool load(FEHFile *f);
+    void save(FEHFile *f) const;
+
+    // {dir} is the sign of the speed
+    Curve &curve(int side, float dir) { return _curves[side][dir < 0.f]; }
+    const Curve &curve(int side, float dir) const { return _curves[side][dir < 0.f]; }
+
+    // percent for a signed speed, in/s
+    float percent(int side, float speed) const;
+    // and back, for code that still thinks in percent
+    float speed(int side, float percent) const;
+    // what both sides average at {percent}
+    float nominalSpeed(float percent) const;
+
+    // {speed}s are magnitudes; samples under MOTOR_MIN_SPEED are left out
+    static Curve fit(const float *percent, const float *speed, int n);
+
+private:
+    Curve _curves[2][2]; // side, reverse
+};
+
+extern MotorMap motorMap;
@@ -0,0 +1,131 @@
+#include <FEHRPS.h>
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "hardware.hpp"
+#include "pose.hpp"
+#include "rps.hpp"
+
+PoseEstimator poseEstimator;
+
+void PoseEstimator::command(float left, float right)
+{
+    // a stopped motor coasts the way it was going
+    integrate();
+    if (left != 0.f)
+        _leftDir = std::copysign(1.f, left);
+    if (right != 0.f)
+        _rightDir = std::copysign(1.f, right);
+}
+
+void PoseEstimator::beforeReset()
+{
+    integrate();
+}
+
+void PoseEstimator::afterReset()
+{
+    _leftCounts = _rightCounts = 0;
+}
+
+void PoseEstimator::integrate()
+{
+    int left = hardware().leftEncoder.Counts(), right = hardware().rightEncoder.Counts();
+    float dl = _leftDir * (left - _leftCounts);
+    float dr = _rightDir * (right - _rightCounts);
+    _leftCounts = left;
+    _rightCounts = right;
+    if (dl == 0.f && dr == 0.f)
+        return;
+
+    float distance = (dl + dr) / (2.f * COUNTS_PER_LINEAR_INCH);
+    float turn = (dr - dl) / COUNTS_PER_DEGREE;
+    float mid = toRadians(_pose.heading + turn / 2.f);
+    _pose.x += distance * std::cos(mid);
+    _pose.y += distance * std::sin(mid);
+    _pose.heading = (Angle(_pose.heading) + turn).degrees();
+}
+
+void PoseEstimator::poll()
+{
+    float now = TimeNow();
+    if (_lastStep >= 0.f && now - _lastStep < POSE_PERIOD)
+        return;
+    _lastStep = now;
+
+    integrate();
+    _history[_head] = {now, _pose};
+    _head = (_head + 1) % POSE_HISTORY;
+
+    // rpsSettle() reads RPS too, so go by the sampler's count rather than
+    // by whether the reading changed since we last looked
+    rpsSampler.poll(now);
+    if (rpsSampler.count() != _packets)
+    {
+        _packets = rpsSampler.count();
+        Point raw = _raw = rpsSampler.latest().pt;
+        // negative values are RPS's "no fix" and "dead zone" sentinels
+        if (raw.x >= 0 && raw.y >= 0 && raw.heading >= 0)
+            fuse(raw, now);
+    }
+}
+
+void PoseEstimator::fuse(Point fix, float now)
+{
+    if (!_valid)
+    {
+        _pose = fix;
+        for (Sample &s : _history)
+            s = {now, fix};
+        _valid = true;
+        ++_fixes;
+        return;
+    }
+
+    // odometry's pose when RPS took the fix
+    float then = now - RPS_LATENCY;
+    const Sample *past = &_history[(_head + POSE_HISTORY - 1) % POSE_HISTORY];
+    for (const Sample &s : _history)
+    {
+        if (std::fabs(s.time - then) < std::fabs(past->time - then))
+            past = &s;
+    }
+
+    float dx = fix.x - past->pose.x;
+    float dy = fix.y - past->pose.y;
+    float dh = wrapDegrees(fix.heading - past->pose.heading);
+
+    if (std::sqrt(dx * dx + dy * dy) > POSE_GATE_XY || std::fabs(dh) > POSE_GATE_HEADING)
+    {
+        ++_rejects;
+        if (++_rejectRun < POSE_MAX_REJECTS)
+            return;
+        // RPS has disagreed for a while; odometry is the one that's wrong
+        _valid = false;
+        _rejectRun = 0;
+        fuse(fix, now);
+        return;
+    }
+    _rejectRun = 0;
+    ++_fixes;
+
+    // shift the present and the history alike so later fixes line up
+    dx *= POSE_GAIN_XY;
+    dy *= POSE_GAIN_XY;
+    dh *= POSE_GAIN_HEADING;
+    _pose.x += dx;
+    _pose.y += dy;
+    _pose.heading = (Angle(_pose.heading) + dh).degrees();
+    for (Sample &s : _history)
+    {
+        s.pose.x += dx;
+        s.pose.y += dy;
+        s.pose.heading = (Angle(s.pose.heading) + dh).degrees();
+    }
+}
+
+Point PoseEstimator::pose()
+{
+    poll();
+    return _valid ? _pose : rpsToPoint();
+}
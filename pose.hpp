@@ -0,0 +1,70 @@
+#pragma once
+
+#include "drive.hpp"
+
+// how often the estimator steps, s
+static constexpr float POSE_PERIOD = .01f;
+// how much of an RPS fix's disagreement with odometry to take on
+static constexpr float POSE_GAIN_XY = .5f;
+static constexpr float POSE_GAIN_HEADING = .5f;
+// fixes further than this from odometry are treated as outliers...
+static constexpr float POSE_GATE_XY = 4.f;
+static constexpr float POSE_GATE_HEADING = 20.f;
+// ...until this many in a row, when we trust RPS and resync
+static constexpr int POSE_MAX_REJECTS = 5;
+static constexpr int POSE_HISTORY = 32;
+// longest to wait on a fresh fix, s
+static constexpr float POSE_FIX_TIMEOUT = .3f;
+
+// Tracks the robot's pose between RPS fixes. Odometry from the drive
+// encoders is integrated continuously; each RPS fix is compared against
+// where odometry thought we were when RPS took it (RPS_LATENCY ago) and a
+// share of the difference is folded back in. Invalid fixes (RPS's negative
+// sentinels) and outliers are dropped.
+//
+// There are no threads, so poll() has to be called from every loop that
+// waits on something (Scheduler::poll() does it); it only does work every
+// POSE_PERIOD.
+class PoseEstimator
+{
+public:
+    void poll();
+    // latest estimate, polling first
+    Point pose();
+    // false until the first valid RPS fix
+    bool valid() const { return _valid; }
+
+    // the encoders only count, so odometry needs the commanded direction
+    void command(float left, float right);
+    // call before resetting the encoders
+    void beforeReset();
+    void afterReset();
+
+    // the last RPS reading, good or not
+    Point lastFix() const { return _raw; }
+    int fixes() const { return _fixes; }
+    int rejects() const { return _rejects; }
+
+private:
+    struct Sample
+    {
+        float time;
+        Point pose;
+    };
+
+    float _leftDir = 1.f, _rightDir = 1.f;
+    int _leftCounts = 0, _rightCounts = 0;
+    float _lastStep = -1.f;
+    bool _valid = false;
+    Point _pose = {0.f, 0.f, 0.f};
+    Point _raw = {-1.f, -1.f, -1.f};
+    int _packets = 0;
+    Sample _history[POSE_HISTORY] = {};
+    int _head = 0;
+    int _fixes = 0, _rejects = 0, _rejectRun = 0;
+
+    void integrate();
+    void fuse(Point fix, float now);
+};
+
+extern PoseEstimator poseEstimator;
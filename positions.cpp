@@ -0,0 +1,25 @@
+#include <FEHSD.h>
+#include <cstdio>
+
+#include "positions.hpp"
+
+PositionsError loadPositions(FEHFile *file, Point (&points)[WAYPOINT_COUNT], PositionSpread *spreads)
+{
+    if (!file)
+        return POSITIONS_MISSING;
+    // one longer than it should be, so a record that's too long shows
+    static char hex[POSITIONS_HEX_LEN + 2];
+    char format[16];
+    std::snprintf(format, sizeof format, "%%*[^\n]%%%ds", static_cast<int>(POSITIONS_HEX_LEN + 1));
+    if (SD.FScanf(file, format, hex) != 1)
+        return POSITIONS_TRUNCATED;
+    return decodePositions(hex, points, spreads);
+}
+
+void savePositions(FEHFile *file, const Point (&points)[WAYPOINT_COUNT], const PositionSpread (&spreads)[WAYPOINT_COUNT])
+{
+    static char hex[POSITIONS_HEX_LEN + 1];
+    encodePositions(points, spreads, hex);
+    SD.FPrintf(file, POSITIONS_COMMENT, POSITIONS_VERSION, WAYPOINT_COUNT);
+    SD.FPrintf(file, "%s\n", hex);
+}
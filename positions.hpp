@@ -0,0 +1,171 @@
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <FEHSD.h>
+
+#include "geometry.hpp"
+#include "module.hpp"
+
+static constexpr uint16_t POSITIONS_VERSION = 2;
+
+// FNV-1a over every prompt, so a file calibrated against a different set
+// or order of waypoints is turned away rather than read into the wrong ones
+constexpr uint32_t hashPrompts()
+{
+    uint32_t h = 2166136261u;
+    for (const char *p : prompts)
+    {
+        do
+            h = (h ^ static_cast<uint8_t>(*p)) * 16777619u;
+        while (*p++);
+    }
+    return h;
+}
+
+// The calibrated waypoints as they're stored: one record, little-endian,
+// written to SD as hex under a comment line since FEHSD only does text.
+// Loading is a single FScanf straight into a fixed table.
+#pragma pack(push, 1)
+struct PositionsRecord
+{
+    char magic[4]; // "WPTS"
+    uint16_t version;
+    uint16_t count;
+    uint32_t promptsHash;
+    float points[WAYPOINT_COUNT][3]; // x, y, heading, by Waypoint
+    float spreads[WAYPOINT_COUNT][2]; // xy, heading
+    uint32_t crc;                    // CRC-32 of everything before it
+};
+#pragma pack(pop)
+
+// how far the fixes a waypoint was averaged from scattered (CaptureResult's
+// spreads); negative when it's not known, e.g. converted from text
+struct PositionSpread
+{
+    float xy;
+    float heading;
+};
+
+// hex digits in a record on SD, and the line above them
+static constexpr size_t POSITIONS_HEX_LEN = 2 * sizeof(PositionsRecord);
+static constexpr const char *POSITIONS_COMMENT = "# positions v%d, %d waypoints\n";
+
+enum PositionsError
+{
+    POSITIONS_OK,
+    POSITIONS_MISSING,
+    POSITIONS_TRUNCATED, // or too long
+    POSITIONS_NOT_POSITIONS,
+    POSITIONS_WRONG_VERSION,
+    POSITIONS_WRONG_PROMPTS,
+    POSITIONS_BAD_CRC,
+    POSITIONS_INCOMPLETE // a waypoint was skipped
+};
+
+inline const char *positionsErrorName(PositionsError error)
+{
+    static const char *const names[] = {"ok", "missing", "truncated", "not a positions file",
+                                        "wrong version", "calibrated for other prompts", "corrupt (CRC)",
+                                        "a waypoint wasn't captured"};
+    return names[error];
+}
+
+// the usual reflected CRC-32; a record this size doesn't need a table
+inline uint32_t crc32(const void *data, size_t n)
+{
+    const uint8_t *bytes = static_cast<const uint8_t *>(data);
+    uint32_t crc = 0xffffffffu;
+    for (size_t i = 0; i < n; ++i)
+    {
+        crc ^= bytes[i];
+        for (int bit = 0; bit < 8; ++bit)
+            crc = (crc >> 1) ^ (0xedb88320u & -(crc & 1u));
+    }
+    return ~crc;
+}
+
+// {hex} takes POSITIONS_HEX_LEN + 1
+inline void encodePositions(const Point (&points)[WAYPOINT_COUNT], const PositionSpread (&spreads)[WAYPOINT_COUNT],
+                            char *hex)
+{
+    PositionsRecord r;
+    std::memcpy(r.magic, "WPTS", sizeof r.magic);
+    r.version = POSITIONS_VERSION;
+    r.count = WAYPOINT_COUNT;
+    r.promptsHash = hashPrompts();
+    for (int i = 0; i < WAYPOINT_COUNT; ++i)
+    {
+        r.points[i][0] = points[i].x;
+        r.points[i][1] = points[i].y;
+        r.points[i][2] = points[i].heading;
+        r.spreads[i][0] = spreads[i].xy;
+        r.spreads[i][1] = spreads[i].heading;
+    }
+    r.crc = crc32(&r, offsetof(PositionsRecord, crc));
+
+    static const char digits[] = "0123456789abcdef";
+    const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&r);
+    for (size_t i = 0; i < sizeof r; ++i)
+    {
+        *hex++ = digits[bytes[i] >> 4];
+        *hex++ = digits[bytes[i] & 15];
+    }
+    *hex = '\0';
+}
+
+// {points}, and {spreads} if it's given, are only written if the record
+// checks out. The header's read
+// first so a record from another version says so, whatever its length.
+inline PositionsError decodePositions(const char *hex, Point (&points)[WAYPOINT_COUNT],
+                                     PositionSpread *spreads = nullptr)
+{
+    PositionsRecord r;
+    uint8_t *bytes = reinterpret_cast<uint8_t *>(&r);
+    size_t n = 0;
+    for (; n < sizeof r && hex[0] && hex[1]; ++n, hex += 2)
+    {
+        int b = 0;
+        for (int k = 0; k < 2; ++k)
+        {
+            char c = hex[k];
+            int d = c >= '0' && c <= '9' ? c - '0'
+                    : c >= 'a' && c <= 'f' ? c - 'a' + 10
+                    : c >= 'A' && c <= 'F' ? c - 'A' + 10 : -1;
+            if (d < 0)
+                return POSITIONS_NOT_POSITIONS;
+            b = b * 16 + d;
+        }
+        bytes[n] = b;
+    }
+
+    if (n < offsetof(PositionsRecord, points))
+        return POSITIONS_TRUNCATED;
+    if (std::memcmp(r.magic, "WPTS", sizeof r.magic) != 0)
+        return POSITIONS_NOT_POSITIONS;
+    if (r.version != POSITIONS_VERSION)
+        return POSITIONS_WRONG_VERSION;
+    if (n < sizeof r || *hex)
+        return POSITIONS_TRUNCATED;
+    if (r.crc != crc32(&r, offsetof(PositionsRecord, crc)))
+        return POSITIONS_BAD_CRC;
+    if (r.count != WAYPOINT_COUNT || r.promptsHash != hashPrompts())
+        return POSITIONS_WRONG_PROMPTS;
+    for (int i = 0; i < WAYPOINT_COUNT; ++i)
+    {
+        if (r.points[i][0] < 0.f || r.points[i][1] < 0.f || r.points[i][2] < 0.f)
+            return POSITIONS_INCOMPLETE;
+    }
+    for (int i = 0; i < WAYPOINT_COUNT; ++i)
+    {
+        points[i] = {r.points[i][0], r.points[i][1], r.points[i][2]};
+        if (spreads)
+            spreads[i] = {r.spreads[i][0], r.spreads[i][1]};
+    }
+    return POSITIONS_OK;
+}
+
+// one read of {file} (POSITIONS_MISSING if it's null) into {points}
+PositionsError loadPositions(FEHFile *file, Point (&points)[WAYPOINT_COUNT], PositionSpread *spreads = nullptr);
+void savePositions(FEHFile *file, const Point (&points)[WAYPOINT_COUNT], const PositionSpread (&spreads)[WAYPOINT_COUNT]);
@@ -0,0 +1,170 @@
+#include <FEHUtility.h>
+#include <cstring>
+
+#include "profile.hpp"
+
+#if PROFILE_ENABLED
+Profiler profiler;
+
+int Profiler::entry(const char *name)
+{
+    for (int i = 0; i < _nentries; ++i)
+    {
+        if (std::strcmp(_entries[i].name, name) == 0)
+            return i;
+    }
+    if (_nentries == PROFILE_MAX_ENTRIES)
+        return -1;
+    _entries[_nentries].name = name;
+    return _nentries++;
+}
+
+void Profiler::enter(int entry)
+{
+    ++_scopes;
+    if (_depth < PROFILE_MAX_DEPTH)
+        _stack[_depth] = {entry, static_cast<float>(TimeNow()), 0.f};
+    ++_depth;
+}
+
+void Profiler::exit(int entry)
+{
+    float now = TimeNow();
+    if (--_depth >= PROFILE_MAX_DEPTH || entry < 0)
+        return;
+
+    Frame &frame = _stack[_depth];
+    float elapsed = now - frame.start;
+    float self = elapsed - frame.nested;
+    // a scope the stack had no room for counts as part of its parent
+    if (_depth > 0)
+        _stack[_depth - 1].nested += elapsed;
+
+    Entry &e = _entries[entry];
+    ++e.calls;
+    e.total += elapsed;
+    e.self += self;
+    if (elapsed > e.max)
+        e.max = elapsed;
+
+    if (_task >= 0)
+    {
+        _tasks[_task].self[entry] += self;
+        if (_depth == 0)
+            _tasks[_task].covered += elapsed;
+    }
+}
+
+void Profiler::count(int entry, int n)
+{
+    if (entry < 0)
+        return;
+    int bucket = 0;
+    for (int v = n; v > 0 && bucket < PROFILE_BUCKETS - 1; v >>= 1)
+        ++bucket;
+    ++_entries[entry].samples;
+    ++_entries[entry].histogram[bucket];
+}
+
+void Profiler::endTask(float now)
+{
+    if (_task >= 0)
+        _tasks[_task].time += now - _taskStart;
+    _task = -1;
+}
+
+void Profiler::task(const char *name)
+{
+    float now = TimeNow();
+    endTask(now);
+    if (!name)
+        return;
+    _taskStart = now;
+    // a task marked twice carries on where it left off
+    for (int i = 0; i < _ntasks; ++i)
+    {
+        if (std::strcmp(_tasks[i].name, name) == 0)
+        {
+            _task = i;
+            return;
+        }
+    }
+    if (_ntasks < PROFILE_MAX_TASKS)
+    {
+        _tasks[_ntasks].name = name;
+        _task = _ntasks++;
+    }
+}
+
+void Profiler::write(FEHFile *f)
+{
+    endTask(TimeNow());
+
+    // what the two clock reads a scope cost, to judge the numbers by
+    static constexpr int reads = 16;
+    float start = TimeNow();
+    for (int i = 0; i < reads; ++i)
+        TimeNow();
+    float perRead = (TimeNow() - start) / (reads + 1);
+    SD.FPrintf(f, "# %ld scopes, ~%f s of it clock reads\n", _scopes, 2.f * perRead * _scopes);
+
+    // heaviest first
+    int order[PROFILE_MAX_ENTRIES];
+    for (int i = 0; i < _nentries; ++i)
+    {
+        int j = i;
+        for (; j > 0 && _entries[order[j - 1]].self < _entries[i].self; --j)
+            order[j] = order[j - 1];
+        order[j] = i;
+    }
+
+    SD.FPrintf(f, "# primitive\tcalls\ttotal\tself\tmean\tmax\n");
+    for (int k = 0; k < _nentries; ++k)
+    {
+        const Entry &e = _entries[order[k]];
+        if (e.calls)
+            SD.FPrintf(f, "%s\t%d\t%f\t%f\t%f\t%f\n", e.name, e.calls, e.total, e.self, e.total / e.calls, e.max);
+    }
+
+    SD.FPrintf(f, "# loop\tcalls\t0\t1");
+    for (int b = 2; b < PROFILE_BUCKETS - 1; ++b)
+        SD.FPrintf(f, "\t%d-%d", 1 << (b - 1), (1 << b) - 1);
+    SD.FPrintf(f, "\t%d+\n", 1 << (PROFILE_BUCKETS - 2));
+    for (int i = 0; i < _nentries; ++i)
+    {
+        const Entry &e = _entries[i];
+        if (!e.samples)
+            continue;
+        SD.FPrintf(f, "%s\t%d", e.name, e.samples);
+        for (int b : e.histogram)
+            SD.FPrintf(f, "\t%d", b);
+        SD.FPrintf(f, "\n");
+    }
+
+    SD.FPrintf(f, "# task\tprimitive\tself\tshare\n");
+    for (int t = 0; t < _ntasks; ++t)
+    {
+        const TaskTime &task = _tasks[t];
+        SD.FPrintf(f, "%s\t*\t%f\t1\n", task.name, task.time);
+        for (int k = 0; k < _nentries; ++k)
+        {
+            float self = task.self[order[k]];
+            if (self > 0.f)
+                SD.FPrintf(f, "%s\t%s\t%f\t%f\n", task.name, _entries[order[k]].name, self,
+                           task.time > 0.f ? self / task.time : 0.f);
+        }
+        // outside every scope: the loops' own logic, the LCD, planning
+        float other = task.time - task.covered;
+        SD.FPrintf(f, "%s\t(other)\t%f\t%f\n", task.name, other, task.time > 0.f ? other / task.time : 0.f);
+    }
+}
+#endif
+
+void writeProfile(FEHFile *f)
+{
+#if PROFILE_ENABLED
+    profiler.write(f);
+#else
+    SD.FPrintf(f, "# built with PROFILE_ENABLED=0\n");
+#endif
+}
@@ -0,0 +1,102 @@
+#pragma once
+
+#include <FEHSD.h>
+
+// build with -DPROFILE_ENABLED=0 and every PROFILE_ macro is empty and
+// there's no profiler
+#ifndef PROFILE_ENABLED
+#define PROFILE_ENABLED 1
+#endif
+
+static constexpr int PROFILE_MAX_ENTRIES = 32;
+static constexpr int PROFILE_MAX_TASKS = 16;
+static constexpr int PROFILE_MAX_DEPTH = 8;
+// iteration histogram buckets: 0, 1, 2-3, 4-7, ..., 16384 and up
+static constexpr int PROFILE_BUCKETS = 16;
+
+// Times the motion, servo and sensing primitives. Each PROFILE_SCOPE
+// charges its time to its entry, both with and without the scopes nested
+// inside it (the self time), and the self time to whatever task the
+// scheduler last marked, so the report splits course time by task and by
+// primitive. PROFILE_COUNT keeps a histogram of a loop's passes per call.
+// Entries are looked up once per call site, then it's two clock reads a
+// scope, so nothing that runs every poll gets one.
+class Profiler
+{
+public:
+    int entry(const char *name);
+    void enter(int entry);
+    void exit(int entry);
+    void count(int entry, int n);
+    // charges what follows to {name}; null for nothing
+    void task(const char *name);
+
+    void write(FEHFile *f);
+
+private:
+    struct Entry
+    {
+        const char *name;
+        int calls;
+        float total, self, max; // s
+        int samples;
+        int histogram[PROFILE_BUCKETS];
+    };
+    struct Frame
+    {
+        int entry;
+        float start, nested;
+    };
+    struct TaskTime
+    {
+        const char *name;
+        float time, covered; // s in all, s inside a top-level scope
+        float self[PROFILE_MAX_ENTRIES];
+    };
+
+    Entry _entries[PROFILE_MAX_ENTRIES] = {};
+    int _nentries = 0;
+    Frame _stack[PROFILE_MAX_DEPTH] = {};
+    int _depth = 0;
+    TaskTime _tasks[PROFILE_MAX_TASKS] = {};
+    int _ntasks = 0, _task = -1;
+    float _taskStart = 0.f;
+    long _scopes = 0;
+
+    void endTask(float now);
+};
+
+// the report, or a line saying the profiler's compiled out
+void writeProfile(FEHFile *f);
+
+#if PROFILE_ENABLED
+// only there when it's built in, so it costs no RAM when it isn't
+extern Profiler profiler;
+
+class ProfileScope
+{
+public:
+    explicit ProfileScope(int entry) : _entry(entry) { profiler.enter(entry); }
+    ~ProfileScope() { profiler.exit(_entry); }
+
+private:
+    int _entry;
+};
+
+#define PROFILE_CAT2(a, b) a##b
+#define PROFILE_CAT(a, b) PROFILE_CAT2(a, b)
+// times the rest of the enclosing block
+#define PROFILE_SCOPE(name)                                                        \
+    static const int PROFILE_CAT(profileEntry, __LINE__) = profiler.entry(name);   \
+    ProfileScope PROFILE_CAT(profileScope, __LINE__)(PROFILE_CAT(profileEntry, __LINE__))
+#define PROFILE_COUNT(name, n)                          \
+    do {                                                \
+        static const int entry = profiler.entry(name);  \
+        profiler.count(entry, n);                       \
+    } while (0)
+#define PROFILE_TASK(name) profiler.task(name)
+#else
+#define PROFILE_SCOPE(name) do {} while (0)
+#define PROFILE_COUNT(name, n) do { (void)(n); } while (0)
+#define PROFILE_TASK(name) do {} while (0)
+#endif
@@ -0,0 +1,156 @@
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "route.hpp"
+#include "pose.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+#include "trajectory.hpp"
+#include "watchdog.hpp"
+
+RouteStats followRoute(const Point *waypoints, int count, bool withHeading)
+{
+    PROFILE_SCOPE("followRoute");
+    RouteStats stats = {};
+    if (count > ROUTE_MAX_POINTS)
+        count = ROUTE_MAX_POINTS;
+    stats.count = count;
+    if (count <= 0 || watchdog.tripped())
+        return stats;
+
+    float startTime = TimeNow();
+
+    // the route starts where we are
+    Point route[ROUTE_MAX_POINTS + 1];
+    float length[ROUTE_MAX_POINTS + 1]; // inches from the start to route[i]
+    int index[ROUTE_MAX_POINTS];        // which waypoint ends each leg
+    route[0] = poseEstimator.pose();
+    length[0] = 0.f;
+    int n = 0;
+    for (int i = 0; i < count; ++i)
+    {
+        // skip waypoints we're already on; the last only if we're right on it
+        float d = pythagoreanDistance(route[n], waypoints[i]);
+        if (d < (i < count - 1 ? ROUTE_LOOKAHEAD / 2.f : DISTANCE_THRESHOLD))
+            continue;
+        index[n] = i;
+        route[++n] = waypoints[i];
+        length[n] = length[n - 1] + d;
+    }
+
+    // heading of each leg, and whether we have to stop at its end to get
+    // round onto the next
+    float legHeading[ROUTE_MAX_POINTS];
+    bool stopAfter[ROUTE_MAX_POINTS];
+    for (int i = 0; i < n; ++i)
+        legHeading[i] = getHeadingToPoint(route[i], route[i + 1]);
+    for (int i = 0; i < n; ++i)
+        stopAfter[i] = i == n - 1 || std::fabs(wrapDegrees(legHeading[i + 1] - legHeading[i])) > ROUTE_MAX_CORNER;
+
+    float timeout = 2.f * length[n] / DRIVE_CREEP_SPEED;
+    float segmentStart = startTime, lastTime = startTime, speed = 0.f;
+    float sumSquares = 0.f;
+    int samples = 0, seg = 0; // on the way from route[seg] to route[seg + 1]
+    int passes = 0;
+    bool stopped = true;
+    Convergence progress(ROUTE_PROGRESS);
+
+    while (seg < n && TimeNow() - startTime < timeout && !watchdog.tripped())
+    {
+        if (stopped)
+        {
+            // too far round to steer into; face down the leg instead
+            Point pose = poseEstimator.pose();
+            if (std::fabs(getChangeInHeading(pose, route[seg + 1])) > TRAJ_MAX_BEARING)
+                turnTo(getHeadingToPoint(pose, route[seg + 1]));
+            stopped = false;
+            speed = DRIVE_CREEP_SPEED;
+            lastTime = TimeNow();
+            // the turn didn't get us any further along
+            progress.reset();
+        }
+
+        scheduler.poll();
+        ++passes;
+
+        float now = TimeNow();
+        float dt = now - lastTime;
+        lastTime = now;
+        Point pose = poseEstimator.pose();
+
+        // where we have to stop next
+        int stop = seg;
+        while (!stopAfter[stop])
+            ++stop;
+        const Point &end = route[stop + 1];
+        float ex = std::cos(legHeading[stop] * RAD), ey = std::sin(legHeading[stop] * RAD);
+
+        float dx = route[seg + 1].x - route[seg].x, dy = route[seg + 1].y - route[seg].y;
+        float leg = std::fmax(length[seg + 1] - length[seg], 1e-3f);
+        float along = ((pose.x - route[seg].x) * dx + (pose.y - route[seg].y) * dy) / leg;
+
+        if (seg == stop ? (end.x - pose.x) * ex + (end.y - pose.y) * ey <= 0.f : along >= leg)
+        {
+            stats.segmentTime[index[seg++]] = now - segmentStart;
+            segmentStart = now;
+            if (seg > stop)
+            {
+                setMotors(0.f, 0.f);
+                stopped = true;
+            }
+            continue;
+        }
+
+        float crossTrack = ((pose.y - route[seg].y) * dx - (pose.x - route[seg].x) * dy) / leg;
+        stats.maxCrossTrack = std::fmax(stats.maxCrossTrack, std::fabs(crossTrack));
+        sumSquares += crossTrack * crossTrack;
+        ++samples;
+
+        // the lookahead point, carried on past the stop along its leg; it
+        // closes in as we get there so we settle onto that leg
+        float s = length[seg] + std::fmax(0.f, along);
+        float toGo = length[stop + 1] - s;
+        if (!progress.update(length[n] - s))
+            break;
+        s += std::fmax(ROUTE_MIN_LOOKAHEAD, std::fmin(ROUTE_LOOKAHEAD, toGo));
+        int i = seg;
+        while (i < stop && s > length[i + 1])
+            ++i;
+        float f = (s - length[i]) / std::fmax(length[i + 1] - length[i], 1e-3f);
+        float gx = route[i].x + f * (route[i + 1].x - route[i].x);
+        float gy = route[i].y + f * (route[i + 1].y - route[i].y);
+
+        float h = pose.heading * RAD;
+        float lx = gx - pose.x, ly = gy - pose.y;
+        float distance = std::fmax(std::sqrt(lx * lx + ly * ly), 1e-3f);
+        float alpha = fastAtan2(std::cos(h) * ly - std::sin(h) * lx, std::cos(h) * lx + std::sin(h) * ly);
+        float k = 2.f * std::sin(alpha) / distance;
+        k = std::fmax(-ROUTE_MAX_CURVATURE, std::fmin(ROUTE_MAX_CURVATURE, k));
+
+        // fast as the curve allows, slowing for corners ahead and the stop
+        float target = std::fmin(arcSpeedLimit(k), std::sqrt(DRIVE_CREEP_SPEED * DRIVE_CREEP_SPEED + 2.f * DRIVE_ACCEL * std::fmax(0.f, toGo - DRIVE_CREEP_DISTANCE)));
+        for (int c = seg + 1; c <= stop; ++c)
+        {
+            float turn = std::fabs(wrapDegrees(legHeading[c] - legHeading[c - 1])) * RAD;
+            float corner = arcSpeedLimit(std::fmin(ROUTE_MAX_CURVATURE, 2.f * std::sin(turn / 2.f) / ROUTE_LOOKAHEAD));
+            float ahead = std::fmax(0.f, length[c] - length[seg] - std::fmax(0.f, along) - ROUTE_LOOKAHEAD);
+            target = std::fmin(target, std::sqrt(corner * corner + 2.f * DRIVE_ACCEL * ahead));
+        }
+        speed = std::fmin(target, speed + DRIVE_ACCEL * dt);
+
+        float left = speed * (1.f - k * AXLETRACK / 2.f);
+        float right = speed * (1.f + k * AXLETRACK / 2.f);
+        setSpeeds(left, right);
+    }
+    setMotors(0.f, 0.f);
+    PROFILE_COUNT("followRoute polls", passes);
+
+    const Point &last = waypoints[stats.count - 1];
+    stats.rmsCrossTrack = samples ? std::sqrt(sumSquares / samples) : 0.f;
+    stats.error = pythagoreanDistance(poseEstimator.pose(), last);
+
+    if (withHeading)
+        turnTo(last.heading);
+    stats.time = TimeNow() - startTime;
+    return stats;
+}
@@ -0,0 +1,31 @@
+#pragma once
+
+#include "drive.hpp"
+
+static constexpr int ROUTE_MAX_POINTS = 8;
+// how far ahead along the route we steer for, inches
+static constexpr float ROUTE_LOOKAHEAD = 4.f;
+static constexpr float ROUTE_MIN_LOOKAHEAD = 1.5f;
+// the tightest we'll steer, 1/in; pure pursuit wants more than the
+// planner's arcs to get round corners
+static constexpr float ROUTE_MAX_CURVATURE = 1.5f / AXLETRACK;
+// corners sharper than this, degrees, we stop and pivot round
+static constexpr float ROUTE_MAX_CORNER = 75.f;
+// in of the route that counts as getting somewhere (watchdog.hpp)
+static constexpr float ROUTE_PROGRESS = .5f;
+
+struct RouteStats
+{
+    float time;                             // s from start to stop
+    float segmentTime[ROUTE_MAX_POINTS];    // s to reach each waypoint
+    float maxCrossTrack;                    // inches off the route, worst
+    float rmsCrossTrack;                    // inches off the route, rms
+    float error;                            // inches from the last waypoint
+    int count;
+};
+
+// drives through {waypoints} in order without stopping, steering for a
+// point ROUTE_LOOKAHEAD along the route and slowing only for corners and
+// the last waypoint, then turns to its heading if {withHeading}. Only
+// corners past ROUTE_MAX_CORNER get a stop and a pivot.
+RouteStats followRoute(const Point *waypoints, int count, bool withHeading);
@@ -0,0 +1,93 @@
+#include <FEHRPS.h>
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "rps.hpp"
+#include "encoders.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+
+RpsSampler rpsSampler;
+
+static bool valid(const Point &pt)
+{
+    return pt.x >= 0.f && pt.y >= 0.f && pt.heading >= 0.f;
+}
+
+static bool agree(const Point &a, const Point &b)
+{
+    return valid(b) && pythagoreanDistance(a, b) <= RPS_SETTLE_XY &&
+           std::fabs(wrapDegrees(a.heading - b.heading)) <= RPS_SETTLE_HEADING;
+}
+
+void RpsSampler::poll(float now)
+{
+    Point pt = rpsToPoint();
+    const Point &last = latest().pt;
+    if (_count > 0 && pt.x == last.x && pt.y == last.y && pt.heading == last.heading)
+        return;
+    _history[_count % RPS_HISTORY] = {now, pt};
+    ++_count;
+}
+
+const RpsFix &RpsSampler::latest(int back) const
+{
+    // further back than we've got: RPS's "no fix", which nothing agrees with
+    static const RpsFix none = {-1.f, {-1.f, -1.f, -1.f}};
+    if (back >= _count || back >= RPS_HISTORY)
+        return none;
+    return _history[(_count - 1 - back + 2 * RPS_HISTORY) % RPS_HISTORY];
+}
+
+Point RpsSampler::settle()
+{
+    PROFILE_SCOPE("rpsSettle");
+    float start = TimeNow(), now = start;
+    bool first = true, extra = false;
+    while (true)
+    {
+        poll(now);
+        float moved = encoderMonitor.lastMoved();
+        if (now - start >= RPS_SETTLE_TIMEOUT)
+        {
+            ++_timeouts;
+            break;
+        }
+        const RpsFix &fix = latest();
+        if (now - moved >= RPS_STILL_TIME && valid(fix.pt))
+        {
+            // taken since we stopped, as far as we know the lag
+            if (fix.time - RPS_LATENCY >= moved)
+            {
+                if (agree(fix.pt, latest(1).pt))
+                {
+                    _immediate += first;
+                    _extra += extra;
+                    break;
+                }
+                extra = true;
+            }
+            else if (now - fix.time >= 1.5f * RPS_PERIOD && now - moved >= 1.5f * RPS_PERIOD + RPS_LATENCY)
+            {
+                ++_quiet;
+                break;
+            }
+        }
+        first = false;
+        scheduler.poll();
+        now = TimeNow();
+    }
+
+    float waited = now - start;
+    ++_settles;
+    _waited += waited;
+    _worst = std::fmax(_worst, waited);
+    return latest().pt;
+}
+
+void RpsSampler::write(FEHFile *f) const
+{
+    SD.FPrintf(f, "# settles\timmediate\tneeded another fix\tquiet\ttimed out\tmean\tworst\tsaved (s)\n");
+    SD.FPrintf(f, "%d\t%d\t%d\t%d\t%d\t%f\t%f\t%f\n", _settles, _immediate, _extra, _quiet, _timeouts,
+               _settles ? _waited / _settles : 0.f, _worst, _settles * PULSE_WIDTH / 1000.f - _waited);
+}
@@ -0,0 +1,60 @@
+#pragma once
+
+#include <FEHSD.h>
+
+#include "drive.hpp"
+
+// s between RPS packets
+static constexpr float RPS_PERIOD = .1f;
+static constexpr int RPS_HISTORY = 8;
+// the robot counts as still once the encoders have been quiet this long, s
+static constexpr float RPS_STILL_TIME = .03f;
+// two fixes this close agree
+static constexpr float RPS_SETTLE_XY = .2f;
+static constexpr float RPS_SETTLE_HEADING = 1.5f;
+// longest settle() waits, s, before it goes with what it has
+static constexpr float RPS_SETTLE_TIMEOUT = .5f;
+
+struct RpsFix
+{
+    float time; // when it arrived, by TimeNow()
+    Point pt;   // negative values are RPS's "no fix" and "dead zone"
+};
+
+// Reads RPS and keeps the last few packets, each stamped with when it
+// turned up. There's no packet counter, so a new packet is a reading that
+// changed; a robot sitting still gets noise, so that's nearly every packet.
+//
+// settle() replaces the fixed PULSE_WIDTH sleep before trusting RPS. It
+// waits for the encoders to go quiet, then for a fix taken since (arrived
+// RPS_LATENCY after they did) that agrees with the one before it. When the
+// link lags more than RPS_LATENCY, that fix was still taken on the move and
+// disagrees, so it waits for the next; when we've been still a while it's
+// already there and settle() returns at once. A reading that hasn't
+// changed for a packet and a half since we stopped counts as confirmed.
+class RpsSampler
+{
+public:
+    // reads RPS; {now} is TimeNow()
+    void poll(float now);
+    // packets seen so far
+    int count() const { return _count; }
+    // the latest packet, and the one {back} before it; an invalid fix if
+    // there haven't been that many
+    const RpsFix &latest(int back = 0) const;
+
+    // waits until RPS shows where we've stopped, and returns the fix
+    Point settle();
+
+    // settles, how long they took against PULSE_WIDTH, and how they ended
+    void write(FEHFile *f) const;
+
+private:
+    RpsFix _history[RPS_HISTORY] = {};
+    int _count = 0;
+
+    int _settles = 0, _immediate = 0, _extra = 0, _quiet = 0, _timeouts = 0;
+    float _waited = 0.f, _worst = 0.f;
+};
+
+extern RpsSampler rpsSampler;
@@ -5,443 +5,478 @@
 #include <FEHUtility.h>
 #include <FEHServo.h>
 #include <FEHSD.h>
+#include <cstdio>
 #include <cstdlib>
 #include <cmath>
 #include <cstring>
 
 #include "module.hpp"
-
-struct Point
-{
-    float x;
-    float y;
-    float heading;
-};
-
-static constexpr float CDS_MARGIN = 0.4f;
-static constexpr float CDS_NO_LIGHT = 3.08f;
-static constexpr float CDS_RED = 0.5f;
-static constexpr float CDS_BLUE = 1.5f;
-
-static AnalogInputPin cds(FEHIO::P0_0);
-
-static FEHMotor leftMotor(FEHMotor::Motor0, 9);
-static FEHMotor rightMotor(FEHMotor::Motor3, 9);
-
-static FEHServo armServo(FEHServo::Servo0);
-static FEHServo wheelServo(FEHServo::Servo7);
-
-static DigitalEncoder leftEncoder(FEHIO::P1_0);  // declaring input pin
-static DigitalEncoder rightEncoder(FEHIO::P1_7); // declaring input pin
-
-static constexpr float AXLETRACK = 7.86f;
-static constexpr float WHEELDIAM = 2.41f;
-static constexpr float TURNPERCENT = 30.f;
-static constexpr float CORRECTION_MULTIPLIER = 1.0711f;
-static constexpr float COUNTS_PER_DEGREE = CORRECTION_MULTIPLIER * (318.f * AXLETRACK / (180.F * WHEELDIAM));
-// THEORETICAL COUNT PER DEGREE : 3.085
-
-// test code for motor shaft encoders
-static constexpr float COUNTS_PER_LINEAR_INCH = 318.0 * 7 / (2 * 22 * (WHEELDIAM / 2));
-
-
-
-static Point rpsToPoint()
+#include "boot.hpp"
+
+#include "drive.hpp"
+#include "light.hpp"
+#include "mission.hpp"
+#include "route.hpp"
+#include "pose.hpp"
+#include "positions.hpp"
+#include "profile.hpp"
+#include "rps.hpp"
+#include "scheduler.hpp"
+#include "status.hpp"
+#include "telemetry.hpp"
+#include "watchdog.hpp"
+
+// built on first use, once main() has started the hardware
+static LightSensor &light()
 {
-    return {RPS.X(), RPS.Y(), RPS.Heading()};
+    static LightSensor sensor(hardware().cds);
+    return sensor;
 }
 
-// moves both wheels forward {distance} inches at {percent} motor percent.
-static void coarseMoveInline(int percent, float distance)
-{
-    // Reset encoder counts
-    rightEncoder.ResetCounts();
-    leftEncoder.ResetCounts();
-
-    // Set both motors to desired percent
-    rightMotor.SetPercent(std::copysign(percent + 1, distance));
-    leftMotor.SetPercent(std::copysign(percent, distance));
+// time for a servo to get where it's told
+static constexpr float SERVO_TRAVEL = .5f;
 
-    float counts = COUNTS_PER_LINEAR_INCH * std::fabs(distance);
+// by Waypoint, from prepare()
+static Point pts[WAYPOINT_COUNT];
 
-    // While the average of the left and right encoder is less than counts,
-    // keep running motors
-    while ((leftEncoder.Counts() + rightEncoder.Counts()) / 2. < counts)
-        ;
+static FEHFile *routeLog;
 
-    // Turn off motors
-    rightMotor.Stop();
-    leftMotor.Stop();
-}
-
-// turns a specified degrees, about center of axle track
-static void pivotTurn(float degrees)
+// drives through {waypoints} without stopping at any but the last
+static void route(const char *name, const Point *waypoints, int n, bool withHeading)
 {
-    float counts = COUNTS_PER_DEGREE * degrees;
-
-    leftMotor.Stop();
-    rightMotor.Stop();
-    rightEncoder.ResetCounts();
-    leftEncoder.ResetCounts();
+    RouteStats stats = followRoute(waypoints, n, withHeading);
 
-    if (degrees > 0)
-    {
-        leftMotor.SetPercent(-TURNPERCENT);
-        rightMotor.SetPercent(TURNPERCENT);
-    }
-    else if (degrees < 0)
-    {
-        counts *= -1.f;
-
-        leftMotor.SetPercent(TURNPERCENT);
-        rightMotor.SetPercent(-TURNPERCENT);
-    }
-
-    float startTime = TimeNow();
-    while ((leftEncoder.Counts() + rightEncoder.Counts() < counts) && (TimeNow() - startTime < 4))
-        ;
-
-    leftMotor.Stop();
-    rightMotor.Stop();
+    SD.FPrintf(routeLog, "%s\t%f\t%f\t%f\t%f", name, stats.time, stats.maxCrossTrack, stats.rmsCrossTrack, stats.error);
+    for (int i = 0; i < stats.count; ++i)
+        SD.FPrintf(routeLog, "\t%f", stats.segmentTime[i]);
+    SD.FPrintf(routeLog, "\n");
 }
 
-static constexpr int PULSE_WIDTH = 200;
-
-static constexpr float PULSE_ANGLE = .5f;
-static constexpr float HEADING_THRESHOLD_COARSE = 5.f;
-static constexpr float HEADING_THRESHOLD = 1.f;
-static void turnTo(float heading)
-{
-    Sleep(PULSE_WIDTH);
-    // coarse turn
-    while (std::fabs(RPS.Heading() - heading) > HEADING_THRESHOLD_COARSE) {
-        pivotTurn(heading - RPS.Heading());
-        Sleep(PULSE_WIDTH);
-    }
-
-    // fine turn w/ RPS
-    while (std::fabs(RPS.Heading() - heading) > HEADING_THRESHOLD)
-    {
-        LCD.Clear();
-        LCD.Write("Intended angle: ");
-        LCD.WriteLine(heading);
-        LCD.Write("Current angle: ");
-        LCD.WriteLine(RPS.Heading());
-        pivotTurn(std::copysign(PULSE_ANGLE, heading - RPS.Heading()));
-        Sleep(PULSE_WIDTH);
-    }
-}
-
-static float pythagoreanDistance(float x1, float y1, float x2, float y2)
-{
-    return std::sqrt((x2 - x1) * (x2 - x1) + (y2 - y1) * (y2 - y1));
-}
-
-static float pythagoreanDistance(Point a, Point b) {
-    return pythagoreanDistance(a.x, a.y, b.x, b.y);
-}
-
-static constexpr float PULSE_DISTANCE = .05f;
-static constexpr float DISTANCE_THRESHOLD = .15f;
-static constexpr float PULSE_POWER = 20.f;
-static void fineMoveInline(float distance, float signedDistance)
-{
-    Point starting = rpsToPoint();
-    Sleep(PULSE_WIDTH);
-    while (distance - pythagoreanDistance(starting, rpsToPoint()) > DISTANCE_THRESHOLD)
-    {
-        coarseMoveInline(PULSE_POWER, std::copysign(PULSE_DISTANCE, signedDistance));
-        Sleep(PULSE_WIDTH);
-    }
-}
-
-static void moveInline(float distance)
+static void throwTray()
 {
-    Point starting = rpsToPoint();
-    coarseMoveInline(40, std::copysign(std::fabs(distance - .75f), distance));
-    Sleep(PULSE_WIDTH);
-    float actualDistance = pythagoreanDistance(starting, rpsToPoint());
-    fineMoveInline(std::fabs(distance) - actualDistance, distance);
-}
+    console.writeLine("\nThrowing tray");
+    setServo(hardware().armServo, 110);
+    console.writeLine("Halfway through...");
+    scheduler.wait(SERVO_TRAVEL);
 
-static void printPoint(Point pt, bool printHeading = true)
-{
-    LCD.Write("X:");
-    LCD.Write(pt.x);
-    LCD.Write("\tY:");
-    LCD.WriteLine(pt.y);
-    if (printHeading)
-    {
-        LCD.Write("Heading: ");
-        LCD.WriteLine(pt.heading);
-    }
+    setServo(hardware().armServo, 60);
+    console.writeLine("Done throwing tray");
 }
 
-static void printPoint()
+static void slideTicketFromStart()
 {
-    printPoint(rpsToPoint());
-}
-
-static float getDegrees(float radians) {
-    return 180.0 * radians / M_PI;
-
-}
-
-static float getHeadingToPoint(Point initial, Point final){
-
-    float xDiff = final.x - initial.x;
-    float yDiff = final.y - initial.y;
-    float angle= getDegrees(atan2(yDiff, xDiff));
-
-    angle=(angle<0)?360+angle:angle;
-    return angle;
+    console.writeLine("Starting first slide...");
+    pivotTurn(-45);
+    console.writeLine("Finished first slide.");
 }
+static void throwTrayTask() {
+    // turn towards sink
+    coarseMoveInline(40, 4);
+    turnTo(230);
 
-static float getChangeInHeading(Point initial, Point final) {
-    
-    float angle = getHeadingToPoint(initial, final);
-    
-    float pivot=angle-initial.heading;
-    return pivot;
-}
+    // move forward and throw
+    coarseMoveInline(40, 4);
+    throwTray();
 
-static void moveTo(Point pt)
-{
-    Sleep(PULSE_WIDTH);
-    Point init = rpsToPoint();
-    turnTo(getHeadingToPoint(init, pt));
-    Sleep(PULSE_WIDTH);
-    moveInline(pythagoreanDistance(init, pt));
+    // go back home
+    coarseMoveInline(40, -8);
 }
 
-static void moveToWithTurn(Point pt){
-    moveTo(pt);
-    turnTo(pt.heading);
+// the arm gets ready on the way to the lever
+static ServoTask &hitReady() {
+    static ServoTask task("arm to 60", hardware().armServo, 60, SERVO_TRAVEL);
+    return task;
 }
 
-static std::vector<Point> pts;
-static const Point invalid_pt = {-2.f, -2.f, -2.f};
-
-static const Point &point_from_prompt(const char *prompt)
-{
-    for (int i = 0; i < nprompts; ++i)
-    {
-        if (std::strcmp(prompt, prompts[i]) == 0)
-            return pts[i];
-    }
-    LCD.WriteLine("Invalid point:");
-    LCD.WriteLine(prompt);
-    return invalid_pt;
+static ServoTask &unhitReady() {
+    static ServoTask task("arm to 170", hardware().armServo, 170, SERVO_TRAVEL);
+    return task;
 }
 
-static void throwTray()
-{
-    LCD.WriteLine("\nThrowing tray");
-    armServo.SetDegree(110);
-    LCD.WriteLine("Halfway through...");
-    Sleep(500);
-
-    armServo.SetDegree(60);
-    LCD.WriteLine("Done throwing tray");
+static void prepareHitLever() {
+    scheduler.start(hitReady());
 }
 
-static void slideTicketFromStart()
-{
-    LCD.WriteLine("Starting first slide...");
-    pivotTurn(-45);
-    LCD.WriteLine("Finished first slide.");
-}
 static void hitLever() {
-    int lever = RPS.GetIceCream();
-    switch (lever) {
-    case 0:
-        moveToWithTurn(point_from_prompt("Behind lever 0"));
-        break;
-    case 1:
-        moveToWithTurn(point_from_prompt("Behind lever 1"));
-        break;
-    case 2:
-        moveToWithTurn(point_from_prompt("Behind lever 2"));
-        break;
-    }
     float angles[] = { -5, 10, 0 }, *a = angles;
-    armServo.SetDegree(60);
+    scheduler.join(hitReady());
     coarseMoveInline(40, 6);
     do {
-        armServo.SetDegree(120);
-        Sleep(500);
-        armServo.SetDegree(60);
+        setServo(hardware().armServo, 120);
+        scheduler.wait(SERVO_TRAVEL);
+        setServo(hardware().armServo, 60);
         pivotTurn(*a);
-        Sleep(100);
+        scheduler.wait(.1f);
     } while (*a++ != 0);
     coarseMoveInline(40, -6);
 }
 
+static void prepareUnhitLever() {
+    scheduler.start(unhitReady());
+}
+
 static void unhitLever() {
-    int lever = RPS.GetIceCream();
-    switch (lever) {
-    case 0:
-        moveToWithTurn(point_from_prompt("Behind lever 0"));
-        break;
-    case 1:
-        moveToWithTurn(point_from_prompt("Behind lever 1"));
-        break;
-    case 2:
-        moveToWithTurn(point_from_prompt("Behind lever 2"));
-        break;
-    }
     float angles[] = { -5, 10, 0 }, *a = angles;
-    armServo.SetDegree(170);
+    scheduler.join(unhitReady());
     coarseMoveInline(40, 6);
     do {
-        armServo.SetDegree(100);
-        Sleep(500);
-        armServo.SetDegree(170);
+        setServo(hardware().armServo, 100);
+        scheduler.wait(SERVO_TRAVEL);
+        setServo(hardware().armServo, 170);
         pivotTurn(*a);
-        Sleep(100);
+        scheduler.wait(.1f);
     } while (*a++ != 0);
     coarseMoveInline(40, -6);
-    armServo.SetDegree(60);
+    setServo(hardware().armServo, 60);
 }
 
 static void slideTicket() {
-    wheelServo.SetDegree(123);
+    setServo(hardware().wheelServo, 123);
     turnTo(180);
     coarseMoveInline(40, -11.5);
     turnTo(270);
-    armServo.SetDegree(0);
+    setServo(hardware().armServo, 0);
     coarseMoveInline(40, 8);
     pivotTurn(-45);
     coarseMoveInline(40, -4);
-    armServo.SetDegree(60);
-    wheelServo.SetDegree(60);
+    setServo(hardware().armServo, 60);
+    setServo(hardware().wheelServo, 60);
 }
 
 static void flipBurger() {
-    moveToWithTurn(point_from_prompt("Behind burger flip"));
-    wheelServo.SetDegree(60);
+    setServo(hardware().wheelServo, 60);
     coarseMoveInline(40, 4);
-    for (int i = 1; i <= 10; ++i) {
-        wheelServo.SetDegree((153.f-60.f)*i/10.f+60.f);
-        Sleep(100);
-    }
-    Sleep(500);
-    wheelServo.SetDegree(60);
-    Sleep(500);
+    ServoSweepTask flip("flip burger", hardware().wheelServo, 60.f, 153.f, 10, .1f);
+    scheduler.start(flip);
+    scheduler.join(flip);
+    scheduler.wait(SERVO_TRAVEL);
+    // back off while the spatula comes down
+    ServoTask lower("lower spatula", hardware().wheelServo, 60, SERVO_TRAVEL);
+    scheduler.start(lower);
     coarseMoveInline(40, -4);
+    scheduler.join(lower);
 }
 
-constexpr float CDS_RED_PCT = (3.07f - 0.29f) / 3.07f;
-constexpr float CDS_BLU_PCT = (3.07f - 1.85f) / 3.07f;
-
-float cdsNoLight = std::nanf("No light value");
+static LightReading jukeboxLight = {LIGHT_NONE, 0.f, 0.f, 0, 0.f};
 
 static void pressJukeboxButton() {
-    moveTo(point_from_prompt("Behind jukebox light"));
     turnTo(270);
     coarseMoveInline(40, 2);
-    Sleep(500);
-    float pct = std::fabs(cds.Value() - cdsNoLight) / cdsNoLight;
-    if (std::fabs(pct-CDS_RED_PCT) < std::fabs(pct-CDS_BLU_PCT)) {
-        LCD.WriteLine("Found a red light");
-    } else {
-        LCD.WriteLine("Found a blue light");
+    // as long as it takes to be sure, up to what the old fixed wait was
+    jukeboxLight = light().classify(SERVO_TRAVEL);
+    console.write("Found a ");
+    console.write(lightName(jukeboxLight.color));
+    console.write(" light, ");
+    console.writeLine(jukeboxLight.confidence);
+}
+
+struct CourseTask
+{
+    const char *name;
+    void (*prepare)(); // before setting off for the task, or null
+    void (*run)();     // once there
+};
+
+// what the names in mission.txt mean
+static const CourseTask courseTasks[] = {
+    { "tray", nullptr, throwTrayTask },
+    { "hitLever", prepareHitLever, hitLever },
+    { "ticket", nullptr, slideTicket },
+    { "burger", nullptr, flipBurger },
+    { "unhitLever", prepareUnhitLever, unhitLever },
+    { "jukebox", nullptr, pressJukeboxButton },
+};
+
+// used when there's no mission.txt; the order the course was first run in
+static const Mission defaultMission = { {
+    { "tray", 4.2f, -1, 0.f, 0.f, 1, { 1 } },
+    { "hitLever", 5.5f, -1, 0.f, 0.f, 2, { 1, MISSION_LEVER } },
+    { "ticket", 6.3f, -1, 0.f, 0.f, 1, { 1 } },
+    { "burger", 4.7f, -1, 0.f, 0.f, 2, { 1, 5 } },
+    { "unhitLever", 4.2f, 1, 7.f, 0.f, 2, { 1, MISSION_LEVER } },
+    { "jukebox", 1.7f, -1, 0.f, 0.f, 3, { 1, 0, 6 } },
+}, 6 };
+
+static Mission mission;
+static RecoveryPolicy recovery[RECOVERY_MAX_POLICIES];
+static int nrecovery = 0;
+
+static const CourseTask *findTask(const char *name)
+{
+    for (const CourseTask &t : courseTasks)
+    {
+        if (std::strcmp(t.name, name) == 0)
+            return &t;
     }
+    return nullptr;
 }
 
-// returns 1 if detects red light, 0 for no or blue light.
-static bool isRedLight()
+static float courseStart;
+// when we started waiting for the light, by TimeNow()
+static float armed;
+
+static void showTime(char *text, int size)
 {
-    return std::fabs(cds.Value() - CDS_RED) < CDS_MARGIN;
+    std::snprintf(text, size, "%.1f", TimeNow() - courseStart);
 }
 
-int RunCourseModule::run()
+static void showPose(char *text, int size)
 {
-    LCD.Clear();
-
-    FEHFile *f = SD.FOpen("position.txt", "r");
-    for (int i = 0; i < nprompts; ++i)
-        pts.push_back(Point{0, 0, 0});
-    int i = nprompts;
-    while (i && (SD.FScanf(f, "%f%f%f", &pts[nprompts - i].x, &pts[nprompts - i].y, &pts[nprompts - i].heading) == 3))
-        --i;
-    if (i > 0)
+    Point p = poseEstimator.pose();
+    std::snprintf(text, size, "%.1f %.1f %.0f", p.x, p.y, p.heading);
+}
+
+// backs away from whatever stopped us, the opposite way to how we were
+// going; straight back if we were turning
+static void backOff()
+{
+    float away = watchdog.direction() < 0.f ? RECOVERY_BACKOFF : -RECOVERY_BACKOFF;
+    watchdog.clear();
+    coarseMoveInline(RECOVERY_PERCENT, away);
+    // if that stuck too there's nothing more to do here
+    watchdog.clear();
+}
+
+// for the legs outside the mission: if the watchdog trips, back off and go
+// again once, then carry on whatever happens with the fault cleared
+static void moveToWithRetry(Point pt)
+{
+    moveToWithTurn(pt);
+    if (!watchdog.tripped())
+        return;
+    watchdog.resolve("back off, retry");
+    backOff();
+    moveToWithTurn(pt);
+    if (watchdog.tripped())
     {
-        LCD.WriteLine("Failed to read all points, recalibration needed");
-        return 1;
+        watchdog.resolve("back off");
+        backOff();
     }
+}
 
-    RPS.InitializeTouchMenu();
+// where to pick {route} back up: the furthest waypoint we're nearer to than
+// the one before it is, so a retry doesn't drive back over legs already done
+static int resumePoint(const Point *route, int n)
+{
+    Point pose = poseEstimator.pose();
+    for (int k = n - 1; k > 0; --k)
+    {
+        if (pythagoreanDistance(pose, route[k]) < pythagoreanDistance(route[k - 1], route[k]))
+            return k;
+    }
+    return 0;
+}
 
-    Sleep(PULSE_WIDTH);
-    const Point init = rpsToPoint();
+class CourseRunner : public MissionRunner
+{
+public:
+    CourseRunner(const MissionRoutes &routes) : _routes(routes) {}
 
-    armServo.SetMin(775);
-    armServo.SetMax(2450);
-    wheelServo.SetMin(690);
-    wheelServo.SetMax(2400);
+    // the task's budget runs from here to the end of perform(), but for the
+    // wait on its constraint in between
+    void travel(int task)
+    {
+        const MissionTask &t = mission.tasks[task];
+        const CourseTask *course = findTask(t.name);
+        scheduler.mark(t.name);
+        status.set("task", t.name);
+        watchdog.begin(t.name, findRecovery(recovery, nrecovery, t.name).budget);
+        if (course && course->prepare)
+            course->prepare();
+        route(t.name, _routes[task], t.npoints, true);
+        watchdog.suspend();
+    }
 
-    armServo.SetDegree(30);
-    wheelServo.SetDegree(63);
+    // does the task, and if the watchdog trips on the way there or here,
+    // recovers as recovery.txt says
+    void perform(int task)
+    {
+        const MissionTask &t = mission.tasks[task];
+        const CourseTask *course = findTask(t.name);
+        RecoveryPolicy policy = findRecovery(recovery, nrecovery, t.name);
+        watchdog.resume();
+        for (int attempt = 1;; ++attempt)
+        {
+            if (!watchdog.tripped())
+            {
+                if (course)
+                    course->run();
+                else
+                {
+                    console.write("Unknown task: ");
+                    console.writeLine(t.name);
+                }
+            }
+            if (!watchdog.tripped())
+                break;
+
+            // out of time is out of goes, however many are left
+            bool last = watchdog.fault() == FAULT_BUDGET || policy.strategy != RECOVER_RETRY || attempt >= policy.attempts;
+            if (watchdog.fault() == FAULT_BUDGET)
+                watchdog.end();
+            if (policy.strategy == RECOVER_SKIP)
+            {
+                watchdog.resolve("skip");
+                watchdog.clear();
+                break;
+            }
+            watchdog.resolve(last ? "back off, skip" : "back off, retry");
+            backOff();
+            if (last)
+                break;
+            int k = resumePoint(_routes[task], t.npoints);
+            route(t.name, _routes[task] + k, t.npoints - k, true);
+        }
+        watchdog.end();
+    }
 
-    LCD.WriteLine("Waiting for light...");
-    while (!isRedLight()) cdsNoLight = cds.Value();
+private:
+    const MissionRoutes &_routes;
+};
 
-    /* the original RPS-less sequence */
-    coarseMoveInline(40, 14.5);
+int RunCourseModule::prepare()
+{
+    FEHFile *f = SD.FOpen(bootConfig.positions, "r");
+    PositionsError error = loadPositions(f, pts);
+    if (f)
+        SD.FClose(f);
+    if (error != POSITIONS_OK)
+    {
+        console.write(bootConfig.positions);
+        console.write(": ");
+        console.writeLine(positionsErrorName(error));
+        console.writeLine("Recalibration needed");
+        return 1;
+    }
 
-    // move to previously calibrated point
-    moveToWithTurn(point_from_prompt("Top of ramp"));
+    loadDriveCalibration();
 
-    //  ___________________________________START OF TRAY TASK
-    // turn towards sink
-    coarseMoveInline(40, 4);
-    turnTo(230);
+    FEHFile *missionFile = SD.FOpen("mission.txt", "r");
+    if (!loadMission(missionFile, mission))
+    {
+        console.writeLine("No usable mission.txt, running the default");
+        mission = defaultMission;
+    }
+    if (missionFile)
+        SD.FClose(missionFile);
 
-    // move forward and throw
-    coarseMoveInline(40, 4);
-    throwTray();
+    FEHFile *recoveryFile = SD.FOpen("recovery.txt", "r");
+    nrecovery = loadRecovery(recoveryFile, recovery);
+    if (recoveryFile)
+        SD.FClose(recoveryFile);
+    return 0;
+}
 
-    // go back home
-    coarseMoveInline(40, -8);
-    moveTo(point_from_prompt("Top of ramp"));
-    //  _______________________END OF TRAY TASK
+int RunCourseModule::run()
+{
+    // the servos get to their start positions and the logs get opened
+    // while RPS is being set up, not after
+    hardware().armServo.SetMin(775);
+    hardware().armServo.SetMax(2450);
+    hardware().wheelServo.SetMin(690);
+    hardware().wheelServo.SetMax(2400);
+
+    telemetry.watchCds(&hardware().cds);
+    telemetry.watchServo(0, &hardware().armServo);
+    telemetry.watchServo(1, &hardware().wheelServo);
 
-    // ice cream lever task begin
-    hitLever();
-    double leverTime = TimeNow();
-    moveTo(point_from_prompt("Top of ramp"));
+    setServo(hardware().armServo, 30);
+    setServo(hardware().wheelServo, 63);
 
-    // sliding ticket task begin
-    slideTicket();
-    moveTo(point_from_prompt("Top of ramp"));
-    // sliding ticket task end
+    routeLog = SD.FOpen("routes.txt", "w");
+    SD.FPrintf(routeLog, "# to\ttime\tmax xte\trms xte\terror\tsegment times\n");
+    FEHFile *telem = SD.FOpen("telem.txt", "w");
 
-    // burger flip task begin
-    flipBurger();
-    moveTo(point_from_prompt("Top of ramp"));
-    // burger flip task end
+    RPS.InitializeTouchMenu();
+
+    rpsSettle();
+    const Point init = rpsToPoint();
 
-    while (TimeNow() - leverTime < 7.0);
-    unhitLever();
-    // ice cream lever task end
+    console.writeLine("Waiting for light...");
+    armed = TimeNow();
+    light().waitForStart();
 
-    moveTo(point_from_prompt("Top of ramp"));
-    moveTo(point_from_prompt("Bottom of ramp"));
+    telemetry.start(telem);
 
-    // jukebox task begin
-    pressJukeboxButton();
-    // jukebox task end
+    courseStart = TimeNow();
+    status.bind("time", showTime);
+    status.bind("pose", showPose);
+
+    scheduler.mark("Start");
+    watchdog.begin("Start", RECOVERY_BUDGET);
+    /* the original RPS-less sequence */
+    coarseMoveInline(40, 14.5);
+    if (watchdog.tripped())
+    {
+        watchdog.resolve("back off");
+        backOff();
+    }
+
+    // move to previously calibrated point
+    moveToWithRetry(pts[TOP_OF_RAMP]);
+    watchdog.end();
+
+    int lever = RPS.GetIceCream();
+    if (lever < 0 || lever > 2)
+        lever = 0;
+    MissionRoutes routes;
+    resolveRoutes(mission, pts, BEHIND_LEVER_0 + lever, routes);
+    MissionPlan plan = planMission(mission, routes, pts[TOP_OF_RAMP], init);
+    if (std::isinf(plan.time))
+        console.writeLine("No order meets the constraints, using the file's");
+    else
+    {
+        console.write("Plan: ");
+        console.write(plan.time);
+        console.writeLine("s");
+    }
 
-    moveToWithTurn(init);
-    LCD.WriteLine("Goodbye.");
+    CourseRunner runner(routes);
+    FEHFile *idle = SD.FOpen("idle.txt", "w");
+    float saved = runMission(mission, plan, routes, runner, idle);
+    SD.FClose(idle);
+    console.write("Idle saved: ");
+    console.write(saved);
+    console.writeLine("s");
+
+    scheduler.mark("Home");
+    watchdog.begin("Home", RECOVERY_BUDGET);
+    moveToWithRetry(init);
+    watchdog.end();
+
+    FEHFile *timeline = SD.FOpen("timeline.txt", "w");
+    scheduler.writeTimeline(timeline);
+    SD.FClose(timeline);
+    SD.FClose(routeLog);
+    telemetry.stop();
+    FEHFile *lightLog = SD.FOpen("light.txt", "w");
+    SD.FPrintf(lightLog, "# start: armed\tambient\tedge\tdetected\tlatency\n");
+    SD.FPrintf(lightLog, "start\t%f\t%f\t%f\t%f\t%f\n", armed, light().ambient(), light().startEdge(),
+               light().startDetected(), light().startDetected() - light().startEdge());
+    SD.FPrintf(lightLog, "# jukebox: colour\tconfidence\tdrop\tsamples\ttime\n");
+    SD.FPrintf(lightLog, "jukebox\t%s\t%f\t%f\t%d\t%f\n", lightName(jukeboxLight.color), jukeboxLight.confidence,
+               jukeboxLight.drop, jukeboxLight.samples, jukeboxLight.time);
+    SD.FClose(lightLog);
+    FEHFile *watchdogLog = SD.FOpen("watchdog.txt", "w");
+    watchdog.write(watchdogLog);
+    SD.FClose(watchdogLog);
+    FEHFile *rpsLog = SD.FOpen("rps.txt", "w");
+    rpsSampler.write(rpsLog);
+    SD.FClose(rpsLog);
+    FEHFile *profile = SD.FOpen("profile.txt", "w");
+    writeProfile(profile);
+    SD.FClose(profile);
+
+    console.writeLine("Goodbye.");
+    // pushing on the final button is meant to stall
+    watchdog.clear();
+    watchdog.enable(false);
     coarseMoveInline(50, -1000000); // FULL FORCE!!!!!!!!!!!!
 
     return 0;
 }
 
-const std::string &RunCourseModule::name() const
+const char *RunCourseModule::name() const
 {
-    static const std::string mod_name("Run the course");
-    return mod_name;
+    return "Run the course";
 }
\ No newline at end of file
@@ -0,0 +1,164 @@
+#include <FEHUtility.h>
+
+#include "scheduler.hpp"
+#include "encoders.hpp"
+#include "pose.hpp"
+#include "profile.hpp"
+#include "status.hpp"
+#include "telemetry.hpp"
+#include "watchdog.hpp"
+
+Scheduler scheduler;
+
+ServoTask::ServoTask(const char *name, FEHServo &servo, float degree, float travel)
+    : _name(name), _servo(servo), _degree(degree), _travel(travel), _start(0.f) {}
+
+void ServoTask::begin()
+{
+    setServo(_servo, _degree);
+    _start = TimeNow();
+}
+
+bool ServoTask::step()
+{
+    return TimeNow() - _start >= _travel;
+}
+
+ServoSweepTask::ServoSweepTask(const char *name, FEHServo &servo, float from, float to, int steps, float interval)
+    : _name(name), _servo(servo), _from(from), _to(to), _interval(interval), _last(0.f), _steps(steps), _step(0) {}
+
+void ServoSweepTask::begin()
+{
+    _step = 0;
+    _last = TimeNow() - _interval;
+}
+
+bool ServoSweepTask::step()
+{
+    if (TimeNow() - _last < _interval)
+        return false;
+    if (_step == _steps)
+        return true;
+    ++_step;
+    setServo(_servo, (_to - _from) * _step / _steps + _from);
+    _last = TimeNow();
+    return false;
+}
+
+int Scheduler::openSpan(const char *name, bool background)
+{
+    if (_nspans == SCHED_MAX_SPANS)
+        return -1;
+    float now = TimeNow();
+    _spans[_nspans] = {name, now, now, 0.f, background};
+    return _nspans++;
+}
+
+void Scheduler::start(Task &task)
+{
+    for (Slot &slot : _slots)
+    {
+        if (slot.task)
+            continue;
+        slot = {&task, openSpan(task.name(), true)};
+        task.begin();
+        return;
+    }
+    // no room: run it in the foreground rather than drop it
+    task.begin();
+    while (!task.step())
+        poll();
+}
+
+void Scheduler::finish(Slot &slot)
+{
+    if (slot.span >= 0)
+        _spans[slot.span].end = TimeNow();
+    slot.task = nullptr;
+}
+
+bool Scheduler::done(const Task &task) const
+{
+    for (const Slot &slot : _slots)
+    {
+        if (slot.task == &task)
+            return false;
+    }
+    return true;
+}
+
+void Scheduler::poll()
+{
+    if (_polling)
+        return;
+    _polling = true;
+
+    // one clock read for everything that only runs every so often
+    float now = TimeNow();
+    // first, since a target's callback may be waiting to stop the motors
+    encoderMonitor.poll(now);
+    watchdog.poll(now);
+    poseEstimator.poll();
+    telemetry.poll(now);
+    status.poll(now);
+    for (Slot &slot : _slots)
+    {
+        if (slot.task && slot.task->step())
+            finish(slot);
+    }
+
+    _polling = false;
+}
+
+void Scheduler::join(Task &task)
+{
+    PROFILE_SCOPE("join");
+    float startTime = TimeNow();
+    int span = -1;
+    for (Slot &slot : _slots)
+    {
+        if (slot.task == &task)
+            span = slot.span;
+    }
+    while (!done(task))
+        poll();
+    if (span >= 0)
+        _spans[span].joined += TimeNow() - startTime;
+}
+
+void Scheduler::wait(float seconds)
+{
+    PROFILE_SCOPE("wait");
+    float startTime = TimeNow();
+    // nothing's moving; a good time to write telemetry out
+    telemetry.flush();
+    while (TimeNow() - startTime < seconds)
+        poll();
+}
+
+void Scheduler::mark(const char *name)
+{
+    telemetry.flush();
+    PROFILE_TASK(name);
+    if (_foreground >= 0)
+        _spans[_foreground].end = TimeNow();
+    _foreground = openSpan(name, false);
+}
+
+void Scheduler::writeTimeline(FEHFile *f)
+{
+    mark(nullptr);
+
+    float hidden = 0.f;
+    SD.FPrintf(f, "# kind\tname\tstart\tend\tjoined\n");
+    for (int i = 0; i < _nspans; ++i)
+    {
+        const Span &s = _spans[i];
+        if (!s.name)
+            continue;
+        SD.FPrintf(f, "%s\t%s\t%f\t%f\t%f\n", s.background ? "task" : "fg", s.name, s.start, s.end, s.joined);
+        if (s.background)
+            hidden += (s.end - s.start) - s.joined;
+    }
+    SD.FPrintf(f, "# background time hidden behind the foreground: %f s\n", hidden);
+}
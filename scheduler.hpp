@@ -0,0 +1,98 @@
+#pragma once
+
+#include <FEHServo.h>
+#include <FEHSD.h>
+
+static constexpr int SCHED_MAX_TASKS = 8;
+static constexpr int SCHED_MAX_SPANS = 64;
+
+// A background job, written as a state machine: begin() once when started,
+// then step() on every scheduler poll until it returns true. Tasks are
+// owned by the caller and must outlive their join.
+class Task
+{
+public:
+    virtual ~Task() {}
+    virtual const char *name() const = 0;
+    virtual void begin() {}
+    virtual bool step() = 0;
+};
+
+// moves a servo and waits out its travel
+class ServoTask : public Task
+{
+public:
+    ServoTask(const char *name, FEHServo &servo, float degree, float travel);
+    const char *name() const { return _name; }
+    void begin();
+    bool step();
+
+private:
+    const char *_name;
+    FEHServo &_servo;
+    float _degree, _travel, _start;
+};
+
+// sweeps a servo from one angle to another in even steps
+class ServoSweepTask : public Task
+{
+public:
+    ServoSweepTask(const char *name, FEHServo &servo, float from, float to, int steps, float interval);
+    const char *name() const { return _name; }
+    void begin();
+    bool step();
+
+private:
+    const char *_name;
+    FEHServo &_servo;
+    float _from, _to, _interval, _last;
+    int _steps, _step;
+};
+
+// Cooperative scheduler. The course code is the foreground: it runs as
+// before, and every loop that waits (the drive primitives, wait()) polls
+// the scheduler, which steps the background tasks, the encoder monitor, the
+// motion watchdog and the pose estimator.
+// join() is the explicit point where the foreground waits on a task.
+//
+// Every task and every foreground mark() gets a span in a timeline, so a
+// run shows how much background work was hidden behind the foreground.
+class Scheduler
+{
+public:
+    void start(Task &task);
+    bool done(const Task &task) const;
+    void join(Task &task);
+    void poll();
+    // like Sleep(), but keeps polling
+    void wait(float seconds);
+
+    // ends the current foreground span and starts a new one
+    void mark(const char *name);
+    void writeTimeline(FEHFile *f);
+
+private:
+    struct Span
+    {
+        const char *name;
+        float start, end;
+        float joined; // s the foreground spent blocked on it
+        bool background;
+    };
+    struct Slot
+    {
+        Task *task;
+        int span;
+    };
+
+    Slot _slots[SCHED_MAX_TASKS] = {};
+    Span _spans[SCHED_MAX_SPANS] = {};
+    int _nspans = 0;
+    int _foreground = -1;
+    bool _polling = false;
+
+    int openSpan(const char *name, bool background);
+    void finish(Slot &slot);
+};
+
+extern Scheduler scheduler;
@@ -0,0 +1,342 @@
+// Simulated implementations of the FEH driver classes used by the robot.
+
+#include <FEHIO.h>
+#include <FEHLCD.h>
+#include <FEHMotor.h>
+#include <FEHRPS.h>
+#include <FEHSD.h>
+#include <FEHServo.h>
+#include <FEHUtility.h>
+
+#include <cstdarg>
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+#include "trace.hpp"
+#include "world.hpp"
+
+using sim::trace;
+using sim::world;
+
+FEHLCD LCD;
+FEHRPS RPS;
+FEHSD SD;
+
+// ---- FEHUtility
+
+void Sleep(int msec) { world().advance(msec / 1000.); }
+void Sleep(float sec) { world().advance(sec); }
+void Sleep(double sec) { world().advance(sec); }
+
+double TimeNow() {
+    world().charge(world().cfg.poll_cost);
+    return world().now - world().epoch;
+}
+
+unsigned int TimeNowSec() { return static_cast<unsigned int>(TimeNow()); }
+unsigned long TimeNowMSec() { return static_cast<unsigned long>(TimeNow() * 1000.); }
+void ResetTime() { world().epoch = world().now; }
+
+// ---- FEHMotor
+
+FEHMotor::FEHMotor(FEHMotorPort motorport, float max_voltage)
+    : _port(motorport), _max_voltage(max_voltage) {}
+
+void FEHMotor::SetPercent(float percent) {
+    if (percent > 100.f) percent = 100.f;
+    if (percent < -100.f) percent = -100.f;
+    world().percent[_port] = percent;
+    trace().output('m', _port, percent);
+    world().charge(world().cfg.poll_cost);
+}
+
+void FEHMotor::Stop() { SetPercent(0.f); }
+
+// ---- FEHServo
+
+FEHServo::FEHServo(FEHServoPort servo) : _servo(servo), _min(500), _max(2500) {}
+void FEHServo::SetMin(int min) { _min = min; }
+void FEHServo::SetMax(int max) { _max = max; }
+void FEHServo::Calibrate() {}
+void FEHServo::Off() {}
+
+void FEHServo::SetDegree(float degree) {
+    if (degree < 0.f) degree = 0.f;
+    if (degree > 180.f) degree = 180.f;
+    world().servo_target[_servo] = degree;
+    trace().output('s', _servo, degree);
+    world().charge(world().cfg.poll_cost);
+}
+
+// ---- FEHIO
+
+DigitalInputPin::DigitalInputPin(FEHIO::FEHIOPin pin) : _pin(pin) {}
+
+bool DigitalInputPin::Value() {
+    world().charge(world().cfg.poll_cost);
+    return trace().read('D', _pin, true); // switches are active low; nothing is pressed
+}
+
+AnalogInputPin::AnalogInputPin(FEHIO::FEHIOPin pin) : _pin(pin) {}
+
+float AnalogInputPin::Value() {
+    world().charge(world().cfg.poll_cost);
+    return trace().read('A', _pin, _pin == FEHIO::P0_0 ? world().cds() : 0.f);
+}
+
+DigitalEncoder::DigitalEncoder(FEHIO::FEHIOPin pin, FEHIO::FEHIOInterruptTrigger)
+    : DigitalEncoder(pin) {}
+
+DigitalEncoder::DigitalEncoder(FEHIO::FEHIOPin pin) : _pin(pin), _offset(0) {}
+
+int DigitalEncoder::Counts() {
+    world().charge(world().cfg.poll_cost);
+    int w = sim::wheel_of_encoder(_pin);
+    return w < 0 ? 0 : static_cast<int>(trace().read('E', w, world().counts(w)) - _offset);
+}
+
+void DigitalEncoder::ResetCounts() {
+    int w = sim::wheel_of_encoder(_pin);
+    _offset = w < 0 ? 0 : static_cast<long>(trace().read('E', w, world().counts(w)));
+}
+
+// ---- FEHRPS
+
+void FEHRPS::InitializeTouchMenu() { world().charge(world().cfg.lcd_clear_cost); }
+int FEHRPS::GetIceCream() { world().charge(world().cfg.poll_cost); return trace().read('I', 0, world().cfg.lever); }
+int FEHRPS::Time() { return static_cast<int>(world().now); }
+
+float FEHRPS::X() {
+    world().charge(world().cfg.poll_cost);
+    return trace().read('X', 0, world().rps.x);
+}
+
+float FEHRPS::Y() {
+    world().charge(world().cfg.poll_cost);
+    return trace().read('Y', 0, world().rps.y);
+}
+
+float FEHRPS::Heading() {
+    world().charge(world().cfg.poll_cost);
+    return trace().read('H', 0, world().rps.heading);
+}
+
+// ---- FEHLCD
+
+static std::string lcd_line;
+
+static void lcd_put(const char *s) {
+    world().charge(world().cfg.lcd_write_cost + world().cfg.lcd_char_cost * std::strlen(s));
+    for (; *s; ++s) {
+        if (*s == '\n') {
+            if (!world().cfg.quiet) std::printf("[%8.3f] %s\n", world().now, lcd_line.c_str());
+            bool stop = !world().cfg.stop_at.empty() && lcd_line.find(world().cfg.stop_at) != std::string::npos;
+            lcd_line.clear();
+            if (stop) world().finish("stop text reached");
+        } else {
+            lcd_line += *s;
+        }
+    }
+}
+
+static void lcd_putf(float f) {
+    char buf[32];
+    std::snprintf(buf, sizeof buf, "%.3f", f);
+    lcd_put(buf);
+}
+
+void FEHLCD::Clear() {
+    world().charge(world().cfg.lcd_clear_cost);
+    if (!lcd_line.empty()) lcd_put("\n");
+}
+
+void FEHLCD::Clear(unsigned int) { Clear(); }
+void FEHLCD::ClearBuffer() {}
+void FEHLCD::SetFontColor(unsigned int) {}
+void FEHLCD::SetBackgroundColor(unsigned int) {}
+
+bool FEHLCD::Touch(float *x_pos, float *y_pos) {
+    sim::World &w = world();
+    w.charge(w.cfg.poll_cost);
+    bool touched;
+    if (!w.menu_done && w.icons_drawn) {
+        *x_pos = w.icon_x;
+        *y_pos = w.icon_y;
+        w.menu_done = true;
+        touched = true;
+    } else if (!w.icons_drawn && w.cfg.boot_touch && !w.boot_touched) {
+        // one tap on whatever's up before the menu, then let go
+        *x_pos = 160.f;
+        *y_pos = 120.f;
+        w.boot_touched = true;
+        touched = true;
+    } else {
+        *x_pos = 160.f;
+        *y_pos = 120.f;
+        // a tap: pressed for one read, let go the next
+        touched = w.menu_done && w.cfg.touch && !w.touch_down;
+        w.touch_down = touched;
+    }
+    *x_pos = trace().read('T', 1, *x_pos);
+    *y_pos = trace().read('T', 2, *y_pos);
+    return trace().read('T', 0, touched);
+}
+
+bool FEHLCD::Touch(int *x_pos, int *y_pos) {
+    float x, y;
+    bool t = Touch(&x, &y);
+    *x_pos = static_cast<int>(x);
+    *y_pos = static_cast<int>(y);
+    return t;
+}
+
+void FEHLCD::Write(const char *str) { lcd_put(str); }
+void FEHLCD::Write(int i) { lcd_put(std::to_string(i).c_str()); }
+void FEHLCD::Write(float f) { lcd_putf(f); }
+void FEHLCD::Write(double d) { lcd_putf(static_cast<float>(d)); }
+void FEHLCD::Write(bool b) { lcd_put(b ? "true" : "false"); }
+void FEHLCD::Write(char c) { char s[2] = {c, 0}; lcd_put(s); }
+
+void FEHLCD::WriteLine(const char *str) { Write(str); lcd_put("\n"); }
+void FEHLCD::WriteLine(int i) { Write(i); lcd_put("\n"); }
+void FEHLCD::WriteLine(float f) { Write(f); lcd_put("\n"); }
+void FEHLCD::WriteLine(double d) { Write(d); lcd_put("\n"); }
+void FEHLCD::WriteLine(bool b) { Write(b); lcd_put("\n"); }
+void FEHLCD::WriteLine(char c) { Write(c); lcd_put("\n"); }
+
+void FEHLCD::WriteAt(const char *str, int, int) { world().charge(world().cfg.lcd_write_cost + world().cfg.lcd_char_cost * std::strlen(str)); }
+void FEHLCD::WriteAt(int i, int x, int y) { WriteAt(std::to_string(i).c_str(), x, y); }
+void FEHLCD::WriteAt(float f, int x, int y) { char buf[32]; std::snprintf(buf, sizeof buf, "%.3f", f); WriteAt(buf, x, y); }
+void FEHLCD::WriteRC(const char *str, int row, int col) { WriteAt(str, col * 12, row * 17); }
+void FEHLCD::WriteRC(int i, int row, int col) { WriteAt(i, col * 12, row * 17); }
+void FEHLCD::WriteRC(float f, int row, int col) { WriteAt(f, col * 12, row * 17); }
+
+void FEHLCD::DrawRectangle(int, int, int, int) { world().charge(world().cfg.lcd_write_cost); }
+void FEHLCD::FillRectangle(int, int, int w, int h) { world().charge(world().cfg.lcd_clear_cost * (w * h) / (320. * 240.)); }
+
+namespace FEHIcon
+{
+    Icon::Icon() : label(), x_start(0), x_end(0), y_start(0), y_end(0), width(0), height(0), color(0), textcolor(0), set(0) {}
+
+    void Icon::SetProperties(const char name[20], int start_x, int start_y, int w, int h, unsigned int c, unsigned int tc) {
+        std::strncpy(label, name, sizeof label - 1);
+        x_start = start_x;
+        y_start = start_y;
+        width = w;
+        height = h;
+        x_end = start_x + w;
+        y_end = start_y + h;
+        color = c;
+        textcolor = tc;
+        set = 0;
+    }
+
+    void Icon::Draw() { world().charge(world().cfg.lcd_write_cost); }
+    void Icon::Select() { set = 1; }
+    void Icon::Deselect() { set = 0; }
+
+    int Icon::Pressed(float x, float y, int) {
+        return x >= x_start && x <= x_end && y >= y_start && y <= y_end;
+    }
+
+    int Icon::WhilePressed(float, float) { return 1; }
+    void Icon::ChangeLabelString(const char new_label[20]) { std::strncpy(label, new_label, sizeof label - 1); }
+    void Icon::ChangeLabelFloat(float val) { std::snprintf(label, sizeof label, "%.2f", val); }
+    void Icon::ChangeLabelInt(int val) { std::snprintf(label, sizeof label, "%d", val); }
+
+    void DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, int left, int right, char labels[][20], unsigned int col, unsigned int txtcol) {
+        int w = (320 - left - right) / cols, h = (240 - top - bot) / rows;
+        for (int r = 0; r < rows; ++r) {
+            for (int c = 0; c < cols; ++c) {
+                int i = r * cols + c;
+                icon[i].SetProperties(labels[i], left + c * w, top + r * h, w, h, col, txtcol);
+                icon[i].Draw();
+                if (i == world().cfg.module) {
+                    world().icon_x = left + c * w + w / 2.f;
+                    world().icon_y = top + r * h + h / 2.f;
+                    world().icons_drawn = true;
+                }
+            }
+        }
+    }
+}
+
+// ---- FEHSD
+
+struct FEHFile {
+    std::string name;
+    size_t pos;
+    bool write;
+};
+
+static FEHFile *open_files[32];
+
+FEHFile *FEHSD::FOpen(const char *str, const char *mode) {
+    sim::World &w = world();
+    w.charge(w.cfg.sd_open_cost);
+    for (FEHFile *&slot : open_files) {
+        if (slot) continue;
+        if (mode[0] == 'r' && !w.files.count(str)) return nullptr;
+        if (mode[0] == 'w') w.files[str].clear();
+        slot = new FEHFile{str, mode[0] == 'a' ? w.files[str].size() : 0, mode[0] != 'r'};
+        return slot;
+    }
+    return nullptr;
+}
+
+int FEHSD::FClose(FEHFile *fptr) {
+    for (FEHFile *&slot : open_files) {
+        if (slot && slot == fptr) {
+            delete slot;
+            slot = nullptr;
+            return 0;
+        }
+    }
+    return -1;
+}
+
+int FEHSD::FCloseAll() {
+    for (FEHFile *&slot : open_files) {
+        delete slot;
+        slot = nullptr;
+    }
+    return 0;
+}
+
+int FEHSD::FPrintf(FEHFile *fptr, const char *format, ...) {
+    if (!fptr || !fptr->write) return -1;
+    world().charge(world().cfg.sd_io_cost);
+    va_list ap, ap2;
+    va_start(ap, format);
+    va_copy(ap2, ap);
+    int n = std::vsnprintf(nullptr, 0, format, ap);
+    va_end(ap);
+    std::string buf(n + 1, '\0');
+    std::vsnprintf(&buf[0], n + 1, format, ap2);
+    va_end(ap2);
+    buf.resize(n);
+    world().files[fptr->name].append(buf);
+    fptr->pos += n;
+    return n;
+}
+
+int FEHSD::FScanf(FEHFile *fptr, const char *format, ...) {
+    if (!fptr) return -1;
+    world().charge(world().cfg.sd_io_cost);
+    std::string &data = world().files[fptr->name];
+    if (fptr->pos >= data.size()) return EOF;
+    FILE *mem = fmemopen(&data[fptr->pos], data.size() - fptr->pos, "r");
+    if (!mem) return EOF;
+    va_list ap;
+    va_start(ap, format);
+    int r = std::vfscanf(mem, format, ap);
+    va_end(ap);
+    fptr->pos += std::ftell(mem);
+    std::fclose(mem);
+    return r;
+}
+
+int FEHSD::FEof(FEHFile *fptr) {
+    return !fptr || fptr->pos >= world().files[fptr->name].size();
+}
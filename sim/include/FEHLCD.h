@@ -0,0 +1,76 @@
+#ifndef FEHLCD_H
+#define FEHLCD_H
+
+#include "FEHUtility.h"
+
+// Host-side stand-in for the Proteus FEHLCD library. Text goes to stdout
+// with a simulator timestamp; touches come from the simulator script.
+
+class FEHLCD
+{
+public:
+    void Clear();
+    void Clear(unsigned int color);
+    void ClearBuffer();
+    void SetFontColor(unsigned int color);
+    void SetBackgroundColor(unsigned int color);
+
+    bool Touch(float *x_pos, float *y_pos);
+    bool Touch(int *x_pos, int *y_pos);
+
+    void Write(const char *str);
+    void Write(int i);
+    void Write(float f);
+    void Write(double d);
+    void Write(bool b);
+    void Write(char c);
+
+    void WriteLine(const char *str);
+    void WriteLine(int i);
+    void WriteLine(float f);
+    void WriteLine(double d);
+    void WriteLine(bool b);
+    void WriteLine(char c);
+
+    void WriteAt(const char *str, int x, int y);
+    void WriteAt(int i, int x, int y);
+    void WriteAt(float f, int x, int y);
+    void WriteRC(const char *str, int row, int col);
+    void WriteRC(int i, int row, int col);
+    void WriteRC(float f, int row, int col);
+
+    void DrawRectangle(int x, int y, int width, int height);
+    void FillRectangle(int x, int y, int width, int height);
+};
+
+extern FEHLCD LCD;
+
+namespace FEHIcon
+{
+    class Icon
+    {
+    public:
+        Icon();
+        void SetProperties(const char name[20], int start_x, int start_y, int width, int height, unsigned int color, unsigned int text_color);
+        void Draw();
+        void Select();
+        void Deselect();
+        int Pressed(float x, float y, int mode);
+        int WhilePressed(float xi, float yi);
+        void ChangeLabelString(const char new_label[20]);
+        void ChangeLabelFloat(float val);
+        void ChangeLabelInt(int val);
+
+    private:
+        char label[200];
+        int x_start, x_end;
+        int y_start, y_end;
+        int width, height;
+        unsigned int color, textcolor;
+        int set;
+    };
+
+    void DrawIconArray(Icon icon[], int rows, int cols, int top, int bot, int left, int right, char labels[][20], unsigned int col, unsigned int txtcol);
+}
+
+#endif
@@ -0,0 +1,27 @@
+#ifndef FEHMOTOR_H
+#define FEHMOTOR_H
+
+// Host-side stand-in for the Proteus FEHMotor library.
+
+class FEHMotor
+{
+public:
+    typedef enum
+    {
+        Motor0 = 0,
+        Motor1,
+        Motor2,
+        Motor3
+    } FEHMotorPort;
+
+    FEHMotor(FEHMotorPort motorport, float max_voltage);
+
+    void SetPercent(float percent);
+    void Stop();
+
+private:
+    FEHMotorPort _port;
+    float _max_voltage;
+};
+
+#endif
@@ -0,0 +1,20 @@
+#ifndef FEHRPS_H
+#define FEHRPS_H
+
+// Host-side stand-in for the Proteus FEHRPS library. Like the real RPS,
+// X/Y/Heading return -1 when there is no fix and -2 in a dead zone.
+
+class FEHRPS
+{
+public:
+    void InitializeTouchMenu();
+    int GetIceCream();
+    float X();
+    float Y();
+    float Heading();
+    int Time();
+};
+
+extern FEHRPS RPS;
+
+#endif
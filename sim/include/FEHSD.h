@@ -0,0 +1,22 @@
+#ifndef FEHSD_H
+#define FEHSD_H
+
+// Host-side stand-in for the Proteus FEHSD library. Files live in memory
+// and are optionally loaded from / written back to a host directory.
+
+struct FEHFile;
+
+class FEHSD
+{
+public:
+    FEHFile *FOpen(const char *str, const char *mode);
+    int FClose(FEHFile *fptr);
+    int FCloseAll();
+    int FPrintf(FEHFile *fptr, const char *format, ...);
+    int FScanf(FEHFile *fptr, const char *format, ...);
+    int FEof(FEHFile *fptr);
+};
+
+extern FEHSD SD;
+
+#endif
@@ -0,0 +1,35 @@
+#ifndef FEHSERVO_H
+#define FEHSERVO_H
+
+// Host-side stand-in for the Proteus FEHServo library.
+
+class FEHServo
+{
+public:
+    typedef enum
+    {
+        Servo0 = 0,
+        Servo1,
+        Servo2,
+        Servo3,
+        Servo4,
+        Servo5,
+        Servo6,
+        Servo7
+    } FEHServoPort;
+
+    FEHServo(FEHServoPort servo);
+
+    void SetMin(int min);
+    void SetMax(int max);
+    void SetDegree(float degree);
+    void Calibrate();
+    void Off();
+
+private:
+    FEHServoPort _servo;
+    int _min;
+    int _max;
+};
+
+#endif
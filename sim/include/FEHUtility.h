@@ -0,0 +1,15 @@
+#ifndef FEHUTILITY_H
+#define FEHUTILITY_H
+
+// Host-side stand-in for the Proteus FEHUtility library. Time is the
+// simulator's clock, not the wall clock.
+
+void Sleep(int msec);
+void Sleep(float sec);
+void Sleep(double sec);
+double TimeNow();
+unsigned int TimeNowSec();
+unsigned long TimeNowMSec();
+void ResetTime();
+
+#endif
@@ -0,0 +1,83 @@
+// Entry point for the host-side simulator. The robot's own main() is
+// compiled as robot_main() and run against the simulated drivers.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+
+#include "trace.hpp"
+#include "world.hpp"
+
+int robot_main();
+
+static void usage(const char *argv0) {
+    std::printf(
+        "usage: %s [options]\n"
+        "  --module N        menu entry to run (default 0)\n"
+        "  --lever N         ice cream lever RPS reports (default 0)\n"
+        "  --jukebox red|blue  jukebox light colour (default red)\n"
+        "  --light-on S      start light turns on after S seconds (default 1)\n"
+        "  --rps-latency S   RPS link latency (default .05)\n"
+        "  --rps-noise IN    RPS position noise std dev (default .05)\n"
+        "  --cds-noise V     CdS reading noise std dev (default .02)\n"
+        "  --snag S          the robot catches on something S seconds in, until it\n"
+        "                    drives the other way\n"
+        "  --max-time S      cut the run off after S simulated seconds (default 180)\n"
+        "  --stop-at TEXT    end the run when the LCD prints TEXT\n"
+        "  --sd DIR          load the SD card from DIR (default sd)\n"
+        "  --sd-out DIR      write the SD card to DIR on exit\n"
+        "  --no-touch        never report a touch after the menu\n"
+        "  --boot-touch      touch the screen once before the menu is up\n"
+        "  --seed N          random seed (default 1)\n"
+        "  --record FILE     write every sensor read and output change to FILE\n"
+        "  --replay FILE     feed the sensor reads back from a --record trace and\n"
+        "                    compare the outputs; exits 1 if they diverge\n"
+        "  --quiet           don't echo the LCD\n",
+        argv0);
+}
+
+int main(int argc, char **argv) {
+    sim::Config &cfg = sim::world().cfg;
+
+    for (int i = 1; i < argc; ++i) {
+        const char *a = argv[i];
+        const char *v = i + 1 < argc ? argv[i + 1] : nullptr;
+        if (!std::strcmp(a, "--quiet")) { cfg.quiet = true; continue; }
+        if (!std::strcmp(a, "--no-touch")) { cfg.touch = false; continue; }
+        if (!std::strcmp(a, "--boot-touch")) { cfg.boot_touch = true; continue; }
+        if (!std::strcmp(a, "--help") || !v) { usage(argv[0]); return !!std::strcmp(a, "--help"); }
+        ++i;
+        if (!std::strcmp(a, "--module")) cfg.module = std::atoi(v);
+        else if (!std::strcmp(a, "--lever")) cfg.lever = std::atoi(v);
+        else if (!std::strcmp(a, "--jukebox")) cfg.jukebox_red = !std::strcmp(v, "red");
+        else if (!std::strcmp(a, "--light-on")) cfg.light_on = std::atof(v);
+        else if (!std::strcmp(a, "--rps-latency")) cfg.rps_latency = std::atof(v);
+        else if (!std::strcmp(a, "--rps-noise")) cfg.rps_pos_noise = std::atof(v);
+        else if (!std::strcmp(a, "--cds-noise")) cfg.cds_noise = std::atof(v);
+        else if (!std::strcmp(a, "--snag")) cfg.snag_at = std::atof(v);
+        else if (!std::strcmp(a, "--max-time")) cfg.max_time = std::atof(v);
+        else if (!std::strcmp(a, "--stop-at")) cfg.stop_at = v;
+        else if (!std::strcmp(a, "--sd")) cfg.sd_in = v;
+        else if (!std::strcmp(a, "--sd-out")) cfg.sd_out = v;
+        else if (!std::strcmp(a, "--seed")) cfg.seed = std::strtoul(v, nullptr, 10);
+        else if (!std::strcmp(a, "--record")) cfg.record = v;
+        else if (!std::strcmp(a, "--replay")) cfg.replay = v;
+        else { usage(argv[0]); return 1; }
+    }
+
+    sim::world().reset();
+    sim::world().load_sd();
+    if (!cfg.record.empty() && !sim::trace().record(cfg.record)) {
+        std::fprintf(stderr, "can't write %s\n", cfg.record.c_str());
+        return 1;
+    }
+    if (!cfg.replay.empty() && !sim::trace().replay(cfg.replay)) {
+        std::fprintf(stderr, "can't read %s\n", cfg.replay.c_str());
+        return 1;
+    }
+
+    int ret = robot_main();
+    char why[32];
+    std::snprintf(why, sizeof why, "module returned %d", ret);
+    sim::world().finish(why);
+}
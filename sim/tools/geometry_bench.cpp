@@ -0,0 +1,80 @@
+// Times geometry.hpp's fast paths against the library on this machine and
+// checks how far off they are.
+//   geometry_bench
+
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+
+#include "geometry.hpp"
+
+static constexpr int N = 1 << 20;
+static constexpr int ROUNDS = 20;
+static float xs[N], ys[N];
+
+// the usual bit trick and one Newton step. It wins here, but the Proteus's
+// FPU does sqrt in one instruction that takes as long as the divide this
+// needs, so it isn't in geometry.hpp
+static float bitSqrt(float v) {
+    uint32_t i;
+    std::memcpy(&i, &v, sizeof i);
+    i = 0x1fbd1df5 + (i >> 1);
+    float g;
+    std::memcpy(&g, &i, sizeof g);
+    return .5f * (g + v / g);
+}
+
+template <typename F>
+static double time(F f) {
+    volatile float sink;
+    float sum = 0.f;
+    auto start = std::chrono::steady_clock::now();
+    for (int r = 0; r < ROUNDS; ++r)
+        for (int i = 0; i < N; ++i)
+            sum += f(ys[i], xs[i]);
+    sink = sum;
+    (void)sink;
+    return std::chrono::duration<double, std::nano>(std::chrono::steady_clock::now() - start).count() / (ROUNDS * N);
+}
+
+int main() {
+    // course-sized offsets in every quadrant
+    for (int i = 0; i < N; ++i) {
+        xs[i] = 36.f * std::sin(i * .37f);
+        ys[i] = 36.f * std::cos(i * .11f) + .01f;
+    }
+
+    float atanWorst = 0.f, sqrtWorst = 0.f;
+    for (int i = 0; i < N; ++i) {
+        atanWorst = std::fmax(atanWorst, std::fabs(wrapDegrees(toDegrees(fastAtan2(ys[i], xs[i]) - std::atan2(ys[i], xs[i])))));
+        float v = xs[i] * xs[i] + ys[i] * ys[i];
+        sqrtWorst = std::fmax(sqrtWorst, std::fabs(bitSqrt(v) / std::sqrt(v) - 1.f));
+    }
+
+    double atan2Time = time([](float y, float x) { return std::atan2(y, x); });
+    double fastTime = time([](float y, float x) { return fastAtan2(y, x); });
+    double sqrtTime = time([](float y, float x) { return std::sqrt(x * x + y * y); });
+    double bitTime = time([](float y, float x) { return bitSqrt(x * x + y * y); });
+
+    std::printf("# kernel\tns\tworst error\n");
+    std::printf("std::atan2\t%.2f\t-\n", atan2Time);
+    std::printf("fastAtan2\t%.2f\t%g deg\n", fastTime, atanWorst);
+    std::printf("std::sqrt\t%.2f\t-\n", sqrtTime);
+    std::printf("bitSqrt\t%.2f\t%g relative\n", bitTime, sqrtWorst);
+
+    // the shortest-turn rules everything else leans on
+    int bad = 0;
+    for (float from = -720.f; from <= 720.f; from += 7.5f) {
+        for (float to = -720.f; to <= 720.f; to += 7.5f) {
+            float turn = Angle(to) - Angle(from);
+            Angle a(from);
+            if (turn <= -180.f || turn > 180.f || std::fabs((a + turn) - Angle(to)) > 1e-3f ||
+                a.degrees() < 0.f || a.degrees() >= 360.f)
+                ++bad;
+        }
+    }
+    std::printf("# %d bad turns\n", bad);
+    return bad != 0;
+}
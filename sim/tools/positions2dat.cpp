@@ -0,0 +1,76 @@
+// Converts a position.txt from before the waypoints were stored as a record
+// (a line of x y heading per prompt, in order, optionally followed by the xy
+// and heading spreads) to position.dat, or with -d prints a position.dat's
+// waypoints back out the same way.
+//   positions2dat position.txt > position.dat
+//   positions2dat -d position.dat
+
+#include <cstdio>
+#include <cstring>
+
+#include "positions.hpp"
+
+static int dump(FILE *in) {
+    char line[POSITIONS_HEX_LEN + 64];
+    while (std::fgets(line, sizeof line, in)) {
+        if (line[0] == '#')
+            continue;
+        line[std::strcspn(line, "\r\n")] = '\0';
+        Point points[WAYPOINT_COUNT];
+        PositionSpread spreads[WAYPOINT_COUNT];
+        PositionsError error = decodePositions(line, points, spreads);
+        if (error != POSITIONS_OK) {
+            std::fprintf(stderr, "%s\n", positionsErrorName(error));
+            return 1;
+        }
+        for (int i = 0; i < WAYPOINT_COUNT; ++i)
+            std::printf("%f\t%f\t%f\t%f\t%f\t# %s\n", points[i].x, points[i].y, points[i].heading,
+                        spreads[i].xy, spreads[i].heading, prompts[i]);
+        return 0;
+    }
+    std::fprintf(stderr, "%s\n", positionsErrorName(POSITIONS_TRUNCATED));
+    return 1;
+}
+
+int main(int argc, char **argv) {
+    bool decode = argc > 1 && std::strcmp(argv[1], "-d") == 0;
+    if (decode) {
+        --argc;
+        ++argv;
+    }
+    FILE *in = argc > 1 ? std::fopen(argv[1], "r") : stdin;
+    if (!in) {
+        std::perror(argv[1]);
+        return 1;
+    }
+    if (decode)
+        return dump(in);
+
+    Point points[WAYPOINT_COUNT];
+    PositionSpread spreads[WAYPOINT_COUNT];
+    char line[256];
+    int i = 0;
+    while (i < WAYPOINT_COUNT && std::fgets(line, sizeof line, in)) {
+        if (line[0] == '#')
+            continue;
+        Point &p = points[i];
+        spreads[i] = {-1.f, -1.f};
+        int n = std::sscanf(line, "%f%f%f%f%f", &p.x, &p.y, &p.heading, &spreads[i].xy, &spreads[i].heading);
+        if (n == 3 || n == 5)
+            ++i;
+        else if (n > 0) {
+            std::fprintf(stderr, "bad line for %s: %s", prompts[i], line);
+            return 1;
+        }
+    }
+    if (i < WAYPOINT_COUNT) {
+        std::fprintf(stderr, "no point for %s\n", prompts[i]);
+        return 1;
+    }
+
+    static char hex[POSITIONS_HEX_LEN + 1];
+    encodePositions(points, spreads, hex);
+    std::printf(POSITIONS_COMMENT, POSITIONS_VERSION, WAYPOINT_COUNT);
+    std::printf("%s\n", hex);
+    return 0;
+}
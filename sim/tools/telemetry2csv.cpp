@@ -0,0 +1,61 @@
+// Converts telem.txt off the robot's SD card to CSV.
+//   telemetry2csv telem.txt > telem.csv
+
+#include <cstdio>
+#include <cstring>
+
+#include "telemetry.hpp"
+
+static int hex(char c) {
+    if (c >= '0' && c <= '9') return c - '0';
+    if (c >= 'a' && c <= 'f') return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F') return c - 'A' + 10;
+    return -1;
+}
+
+int main(int argc, char **argv) {
+    FILE *in = argc > 1 ? std::fopen(argv[1], "r") : stdin;
+    if (!in) {
+        std::perror(argv[1]);
+        return 1;
+    }
+
+    std::printf("time,left_counts,right_counts,left_percent,right_percent,arm,wheel,"
+                "rps_x,rps_y,rps_heading,x,y,heading,cds\n");
+
+    char line[256];
+    int lineno = 0, bad = 0;
+    while (std::fgets(line, sizeof line, in)) {
+        ++lineno;
+        if (line[0] == '#') {
+            int version;
+            if (std::sscanf(line, "# telemetry v%d", &version) == 1 && version != TELEMETRY_VERSION) {
+                std::fprintf(stderr, "telemetry v%d, expected v%d\n", version, TELEMETRY_VERSION);
+                return 1;
+            }
+            std::fputs(line, stderr);
+            continue;
+        }
+
+        TelemetryRecord r;
+        unsigned char *bytes = reinterpret_cast<unsigned char *>(&r);
+        size_t n = std::strcspn(line, "\r\n");
+        bool ok = n == 2 * sizeof r;
+        for (size_t i = 0; ok && i < sizeof r; ++i) {
+            int hi = hex(line[2 * i]), lo = hex(line[2 * i + 1]);
+            ok = hi >= 0 && lo >= 0;
+            bytes[i] = static_cast<unsigned char>(hi << 4 | lo);
+        }
+        if (!ok) {
+            std::fprintf(stderr, "line %d: not a record\n", lineno);
+            ++bad;
+            continue;
+        }
+
+        std::printf("%.3f,%d,%d,%d,%d,%d,%d,%.2f,%.2f,%.2f,%.2f,%.2f,%.2f,%.3f\n",
+                    r.time / 1000., r.leftCounts, r.rightCounts, r.leftPercent, r.rightPercent,
+                    r.servo[0], r.servo[1], r.rpsX / 100., r.rpsY / 100., r.rpsHeading / 50.,
+                    r.x / 100., r.y / 100., r.heading / 50., r.cds / 1000.);
+    }
+    return bad ? 2 : 0;
+}
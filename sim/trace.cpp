@@ -0,0 +1,135 @@
+#include "trace.hpp"
+
+#include "world.hpp"
+
+namespace sim {
+
+Trace &trace() {
+    static Trace inst;
+    return inst;
+}
+
+bool Trace::record(const std::string &path) {
+    _out = std::fopen(path.c_str(), "w");
+    if (!_out) return false;
+    std::fprintf(_out, "# sim trace: time kind port value\n");
+    return true;
+}
+
+bool Trace::replay(const std::string &path) {
+    FILE *in = std::fopen(path.c_str(), "r");
+    if (!in) return false;
+    char line[128];
+    while (std::fgets(line, sizeof line, in)) {
+        double t, v;
+        char kind;
+        int port;
+        long n;
+        if (line[0] == '#') {
+            if (std::sscanf(line, "# reads %c %d %ld", &kind, &port, &n) == 3)
+                _channels[Key(kind, port)].golden_reads = n;
+            continue;
+        }
+        if (std::sscanf(line, "%lf %c %d %lf", &t, &kind, &port, &v) != 4) continue;
+        if (kind == 'm' || kind == 's')
+            _golden.push_back({t, kind, port, v});
+        else
+            _channels[Key(kind, port)].samples.push_back({t, v});
+    }
+    std::fclose(in);
+    _replaying = true;
+    return true;
+}
+
+void Trace::write(double t, char kind, int port, double v) {
+    // %.17g so times and values read back bit for bit
+    std::fprintf(_out, "%.17g %c %d %.17g\n", t, kind, port, v);
+}
+
+double Trace::read(char kind, int port, double live) {
+    if (!_out && !_replaying) return live;
+    Channel &c = _channels[Key(kind, port)];
+    ++c.reads;
+    if (_replaying) {
+        // the last value recorded at or before now; before the first, the first
+        double now = world().now;
+        while (c.cursor + 1 < c.samples.size() && c.samples[c.cursor + 1].t <= now) ++c.cursor;
+        return c.samples.empty() ? live : c.samples[c.cursor].v;
+    }
+    if (!c.seen || c.last != live) write(world().now, kind, port, live);
+    c.seen = true;
+    c.last = live;
+    return live;
+}
+
+void Trace::check(const Output &got) {
+    size_t i = _next++;
+    if (_diverged) return;
+    if (i < _golden.size()) {
+        const Output &want = _golden[i];
+        if (want.t == got.t && want.kind == got.kind && want.port == got.port && want.v == got.v) return;
+        _expected = want;
+    } else {
+        _expected = {_golden.empty() ? 0. : _golden.back().t, '-', 0, 0.};
+    }
+    _diverged = true;
+    _diverged_at = i;
+    _got = got;
+}
+
+void Trace::output(char kind, int port, double value) {
+    if (!_out && !_replaying) return;
+    auto it = _outputs.find(Key(kind, port));
+    if (it != _outputs.end() && it->second == value) return;
+    _outputs[Key(kind, port)] = value;
+    ++_changes;
+    if (_replaying)
+        check({world().now, kind, port, value});
+    else
+        write(world().now, kind, port, value);
+}
+
+int Trace::finish() {
+    if (_out) {
+        for (auto &c : _channels)
+            std::fprintf(_out, "# reads %c %d %ld\n", c.first.first, c.first.second, c.second.reads);
+        std::fclose(_out);
+        _out = nullptr;
+        return 0;
+    }
+    if (!_replaying) return 0;
+
+    // reads are summed by kind; a loop that runs longer or shorter shows here
+    std::map<char, std::pair<long, long>> reads;
+    for (auto &c : _channels) {
+        reads[c.first.first].first += c.second.reads;
+        reads[c.first.first].second += c.second.golden_reads;
+    }
+    std::printf("trace: reads");
+    for (auto &r : reads) std::printf("  %c %ld/%ld", r.first, r.second.first, r.second.second);
+    std::printf("  (replay/golden)\n");
+    std::printf("trace: %ld output changes, golden %zu\n", _changes, _golden.size());
+
+    if (!_diverged && _next < _golden.size()) {
+        _diverged = true;
+        _diverged_at = _next;
+        _expected = _golden[_next];
+        _got = {world().now, '-', 0, 0.};
+    }
+    if (!_diverged) {
+        std::printf("trace: no divergence\n");
+        return 0;
+    }
+    std::printf("trace: diverged at output change %zu\n", _diverged_at);
+    const Output *sides[] = {&_expected, &_got};
+    const char *names[] = {"golden", "replay"};
+    for (int i = 0; i < 2; ++i) {
+        if (sides[i]->kind == '-')
+            std::printf("trace:   %s  %.6f ended\n", names[i], sides[i]->t);
+        else
+            std::printf("trace:   %s  %.6f %c %d %g\n", names[i], sides[i]->t, sides[i]->kind, sides[i]->port, sides[i]->v);
+    }
+    return 1;
+}
+
+} // namespace sim
@@ -0,0 +1,78 @@
+#pragma once
+
+#include <cstdio>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Sensor traces, for scoring a build against a golden run.
+//
+// Recording writes every sensor read the robot makes, each channel only
+// when its value changes, and every change of a motor or servo output,
+// all stamped with the virtual clock. Replaying answers the robot's reads
+// from a recording, by time, instead of from the world, and checks the
+// outputs against the recorded ones as they happen. Since the clock only
+// moves with what the code does, an unchanged build replays exactly; a
+// changed one still sees the recorded sensors, and the report says how
+// many reads it made and where its outputs first went another way.
+//
+// Channels are a kind and a port:
+//   X Y H  RPS x, y, heading          E  encoder counts, by wheel, raw
+//   A      analog input, by pin       D  digital input, by pin
+//   T      touch: 0 pressed, 1 x, 2 y I  RPS ice cream lever
+//   m      motor percent, by port     s  servo degree, by port
+namespace sim {
+
+class Trace {
+public:
+    bool record(const std::string &path);
+    bool replay(const std::string &path);
+    bool replaying() const { return _replaying; }
+
+    // {live} is what the world says; returns what the robot should see
+    double read(char kind, int port, double live);
+    void output(char kind, int port, double value);
+
+    // ends the recording, or prints the replay's report; returns nonzero
+    // if the replay diverged
+    int finish();
+
+private:
+    typedef std::pair<char, int> Key;
+    struct Sample {
+        double t, v;
+    };
+    struct Channel {
+        std::vector<Sample> samples;
+        size_t cursor = 0;
+        double last = 0.;
+        bool seen = false;
+        long reads = 0, golden_reads = 0;
+    };
+    struct Output {
+        double t;
+        char kind;
+        int port;
+        double v;
+    };
+
+    std::map<Key, Channel> _channels;
+    std::map<Key, double> _outputs; // last value of each
+    std::vector<Output> _golden;
+    size_t _next = 0; // golden output the next change should match
+    long _changes = 0;
+    FILE *_out = nullptr;
+    bool _replaying = false;
+
+    bool _diverged = false;
+    Output _expected = {}, _got = {};
+    size_t _diverged_at = 0;
+
+    void write(double t, char kind, int port, double v);
+    void check(const Output &got);
+};
+
+Trace &trace();
+
+} // namespace sim
@@ -0,0 +1,191 @@
+#include "world.hpp"
+#include "trace.hpp"
+
+#include <chrono>
+#include <cmath>
+#include <cstdio>
+#include <cstdlib>
+#include <dirent.h>
+#include <fstream>
+#include <sstream>
+#include <sys/stat.h>
+
+namespace sim {
+
+static const auto wall_start = std::chrono::steady_clock::now();
+
+World &world() {
+    static World inst;
+    return inst;
+}
+
+// wiring, as in runcourse.cpp
+int wheel_of_motor(int port) {
+    switch (port) {
+    case 0: return 0;
+    case 3: return 1;
+    default: return -1;
+    }
+}
+
+int wheel_of_encoder(int pin) {
+    switch (pin) {
+    case 8: return 0;  // P1_0
+    case 15: return 1; // P1_7
+    default: return -1;
+    }
+}
+
+void World::reset() {
+    rng.seed(cfg.seed);
+    pose = cfg.start;
+    now = epoch = _acc = 0.;
+    _next_rps = 0.;
+    _snag = 0;
+    _unsnagged = false;
+    _pending.clear();
+    rps = {0., -1.f, -1.f, -1.f};
+}
+
+double World::gauss(double sigma) {
+    if (sigma <= 0.) return 0.;
+    return std::normal_distribution<double>(0., sigma)(rng);
+}
+
+void World::advance(double seconds) {
+    // each step sees its own time, so what it samples (RPS) is stamped
+    // with when it happened, not with the end of a long Sleep()
+    double end = now + seconds;
+    _acc += seconds;
+    while (_acc >= STEP) {
+        _acc -= STEP;
+        now = end - _acc;
+        step(STEP);
+    }
+    now = end;
+    if (now > cfg.max_time) finish("time limit reached");
+}
+
+void World::step(double dt) {
+    // a snag catches whatever we're doing when it comes up, and lets go
+    // once the robot drives the other way (or at all, after a turn)
+    if (cfg.snag_at >= 0. && now >= cfg.snag_at && !_unsnagged) {
+        double drive = 0., effort = 0.;
+        for (int port = 0; port < 4; ++port) {
+            if (wheel_of_motor(port) < 0) continue;
+            drive += percent[port];
+            effort += std::fabs(percent[port]);
+        }
+        bool straight = std::fabs(drive) > 10.;
+        if (!_snag && effort > 0.) {
+            _snag = straight ? (drive > 0. ? 1 : -1) : 2;
+            std::printf("[%8.3f] sim: snagged\n", now);
+        } else if (_snag && straight && (_snag == 2 || (drive > 0.) != (_snag > 0))) {
+            _unsnagged = true;
+            std::printf("[%8.3f] sim: unsnagged\n", now);
+        }
+    }
+    bool snagged = _snag && !_unsnagged;
+
+    // motors: deadband, per-side gain, first-order lag
+    for (int port = 0; port < 4; ++port) {
+        int w = wheel_of_motor(port);
+        if (w < 0) continue;
+        double p = std::fabs(percent[port]);
+        double target = p <= cfg.deadband ? 0.
+            : std::copysign((p - cfg.deadband) / (100. - cfg.deadband) * cfg.max_speed, percent[port]);
+        target *= (w == 0 ? cfg.left_gain : cfg.right_gain) * (1. + gauss(cfg.speed_noise));
+        if (snagged) target = 0.;
+        double tau = std::fabs(target) < std::fabs(wheel_vel[w]) ? cfg.brake_tau : cfg.motor_tau;
+        wheel_vel[w] += (target - wheel_vel[w]) * (dt / (tau + dt));
+    }
+
+    // differential drive kinematics
+    double v = (wheel_vel[0] + wheel_vel[1]) / 2.;
+    double omega = (wheel_vel[1] - wheel_vel[0]) / cfg.axletrack;
+    double mid = pose.heading + omega * dt / 2.;
+    pose.x += v * std::cos(mid) * dt;
+    pose.y += v * std::sin(mid) * dt;
+    pose.heading = std::fmod(pose.heading + omega * dt, 2. * M_PI);
+    if (pose.heading < 0.) pose.heading += 2. * M_PI;
+    wheel_dist[0] += std::fabs(wheel_vel[0]) * dt;
+    wheel_dist[1] += std::fabs(wheel_vel[1]) * dt;
+
+    for (int i = 0; i < 8; ++i) {
+        double d = servo_target[i] - servo_angle[i], lim = cfg.servo_rate * dt;
+        servo_angle[i] += d > lim ? lim : d < -lim ? -lim : d;
+    }
+
+    // RPS: sample now, deliver after the link latency
+    if (now >= _next_rps) {
+        _next_rps += cfg.rps_period;
+        std::uniform_real_distribution<double> u(0., 1.);
+        RpsPacket pkt;
+        pkt.arrive = now + cfg.rps_latency;
+        if (u(rng) < cfg.rps_dropout) {
+            pkt.x = pkt.y = pkt.heading = -1.f;
+        } else {
+            double h = std::fmod(pose.heading * 180. / M_PI + gauss(cfg.rps_heading_noise) + 360., 360.);
+            pkt.x = pose.x + gauss(cfg.rps_pos_noise);
+            pkt.y = pose.y + gauss(cfg.rps_pos_noise);
+            pkt.heading = h;
+        }
+        _pending.push_back(pkt);
+    }
+    while (!_pending.empty() && _pending.front().arrive <= now) {
+        rps = _pending.front();
+        _pending.pop_front();
+    }
+}
+
+long World::counts(int wheel) const {
+    return static_cast<long>(wheel_dist[wheel] * cfg.counts_per_rev / (M_PI * cfg.wheeldiam));
+}
+
+double World::cds() {
+    double sx = pose.x + cfg.cds_offset * std::cos(pose.heading);
+    double sy = pose.y + cfg.cds_offset * std::sin(pose.heading);
+    double v = cfg.cds_ambient;
+    if (now >= cfg.light_on && std::hypot(sx - cfg.start.x, sy - cfg.start.y) < cfg.light_radius)
+        v = cfg.cds_red;
+    else if (std::hypot(sx - cfg.jukebox.x, sy - cfg.jukebox.y) < cfg.light_radius)
+        v = cfg.jukebox_red ? cfg.cds_red : cfg.cds_blue;
+    return v + gauss(cfg.cds_noise);
+}
+
+void World::load_sd() {
+    DIR *d = opendir(cfg.sd_in.c_str());
+    if (!d) return;
+    while (dirent *e = readdir(d)) {
+        std::string path = cfg.sd_in + "/" + e->d_name;
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0 || !S_ISREG(st.st_mode)) continue;
+        std::ifstream in(path, std::ios::binary);
+        std::stringstream ss;
+        ss << in.rdbuf();
+        files[e->d_name] = ss.str();
+    }
+    closedir(d);
+}
+
+void World::save_sd() {
+    if (cfg.sd_out.empty()) return;
+    mkdir(cfg.sd_out.c_str(), 0755);
+    for (auto &f : files) {
+        std::ofstream out(cfg.sd_out + "/" + f.first, std::ios::binary);
+        out << f.second;
+    }
+}
+
+void World::finish(const char *why) {
+    double wall = std::chrono::duration<double>(std::chrono::steady_clock::now() - wall_start).count();
+    std::printf("[%8.3f] sim: %s\n", now, why);
+    std::printf("sim: %.3f s simulated in %.3f s wall (%.0fx)\n", now, wall, wall > 0. ? now / wall : 0.);
+    std::printf("sim: final pose x=%.2f y=%.2f heading=%.1f\n", pose.x, pose.y, pose.heading * 180. / M_PI);
+    save_sd();
+    int status = trace().finish();
+    std::fflush(stdout);
+    std::_Exit(status);
+}
+
+} // namespace sim
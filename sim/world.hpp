@@ -0,0 +1,140 @@
+#pragma once
+
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <random>
+#include <string>
+
+// Simulated robot and course. Everything runs on a virtual clock: driver
+// calls charge a small amount of CPU time and Sleep() jumps ahead, so a
+// full course runs much faster than real time.
+namespace sim {
+
+struct Pose {
+    double x, y;    // inches, RPS frame
+    double heading; // radians, CCW from +x
+};
+
+struct Config {
+    // geometry (matches AXLETRACK/WHEELDIAM in the robot code)
+    double axletrack = 7.86;
+    double wheeldiam = 2.41;
+    double counts_per_rev = 318.;
+    double cds_offset = 1.5; // CdS cell ahead of the axle, inches
+
+    // drive motors: Motor0 left, Motor3 right
+    double max_speed = 20.;    // wheel surface speed at 100%, in/s
+    double deadband = 8.;      // percent below which the wheel doesn't move
+    double motor_tau = .08;    // first-order lag spinning up, s
+    double brake_tau = .02;    // and slowing down (gearbox drag), s
+    double left_gain = 1.;
+    double right_gain = .975;  // the right side is a bit weak
+    double speed_noise = .01;  // relative, per step
+    // from this time (s, if >= 0) the robot catches on something and its
+    // wheels stop, until it's driven the other way
+    double snag_at = -1.;
+
+    // servos
+    double servo_rate = 400.; // deg/s
+
+    // RPS
+    double rps_period = .1;        // s between packets
+    double rps_latency = .05;      // s from sample to arrival
+    double rps_pos_noise = .05;    // in, std dev
+    double rps_heading_noise = .4; // deg, std dev
+    double rps_dropout = .01;      // probability a packet reads -1
+    int lever = 0;                 // RPS.GetIceCream()
+
+    // CdS: ADC volts
+    double cds_ambient = 3.08;
+    double cds_red = .35;
+    double cds_blue = 1.6;
+    double cds_noise = .02;
+    double light_radius = 2.5;
+    double light_on = 1.;            // s after boot the start light turns red
+    bool jukebox_red = true;
+    Pose start = {30., 12., 2.356};  // start pose; the start light is here
+    Pose jukebox = {9., 14.5, 0.};   // jukebox light
+
+    // CPU cost of driver calls, microseconds
+    double poll_cost = 20.;
+    double lcd_clear_cost = 15000.;
+    double lcd_write_cost = 1000.;
+    double lcd_char_cost = 100.;
+    double sd_open_cost = 20000.;
+    double sd_io_cost = 1000.;
+
+    // script
+    int module = 0;          // menu entry to pick
+    bool touch = true;       // LCD.Touch reports taps after the menu
+    bool boot_touch = false; // ...and one before it, e.g. on the autorun banner
+    double max_time = 180.;  // s of simulated time before the run is cut off
+    std::string stop_at;     // end the run when the LCD prints this
+    bool quiet = false;
+    unsigned seed = 1;
+    std::string sd_in = "sd";
+    std::string sd_out;
+    std::string record; // write a sensor trace here
+    std::string replay; // answer sensor reads from this trace
+};
+
+struct RpsPacket {
+    double arrive; // s
+    float x, y, heading;
+};
+
+class World {
+public:
+    Config cfg;
+
+    double now = 0.;  // simulated seconds since boot
+    double epoch = 0.; // ResetTime()
+    Pose pose;
+
+    double percent[4] = {};    // commanded motor percent per port
+    double wheel_vel[2] = {};  // actual surface speed, in/s (left, right)
+    double wheel_dist[2] = {}; // unsigned distance travelled, in
+
+    double servo_target[8] = {};
+    double servo_angle[8] = {};
+
+    RpsPacket rps = {0., -1.f, -1.f, -1.f};
+
+    std::map<std::string, std::string> files;
+    bool icons_drawn = false;
+    float icon_x = 0.f, icon_y = 0.f; // centre of the menu entry to pick
+    bool menu_done = false;
+    bool boot_touched = false;
+    bool touch_down = false; // the last tap's still pressed
+
+    void reset();
+    void advance(double seconds);
+    void charge(double micros) { advance(micros * 1e-6); }
+
+    long counts(int wheel) const;
+    double cds();
+
+    void load_sd();
+    void save_sd();
+    [[noreturn]] void finish(const char *why);
+
+    std::mt19937 rng;
+    double gauss(double sigma);
+
+private:
+    static constexpr double STEP = .001;
+    double _acc = 0.;
+    double _next_rps = 0.;
+    int _snag = 0; // which way we were driving when it caught: 1, -1, 2 turning
+    bool _unsnagged = false;
+    std::deque<RpsPacket> _pending;
+    void step(double dt);
+};
+
+World &world();
+
+int wheel_of_motor(int port);
+int wheel_of_encoder(int pin);
+
+} // namespace sim
@@ -0,0 +1,190 @@
+#include <FEHLCD.h>
+#include <algorithm>
+#include <cstdio>
+#include <cstring>
+
+#include "status.hpp"
+
+StatusDisplay status;
+Console console;
+
+static constexpr unsigned int BACKGROUND = 0x000000;
+static constexpr unsigned int FOREGROUND = 0xFFFFFF;
+static constexpr int CHAR_WIDTH = 12, CHAR_HEIGHT = 17;
+
+StatusDisplay::Field *StatusDisplay::find(const char *name)
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        if (_fields[i].name == name || std::strcmp(_fields[i].name, name) == 0)
+            return &_fields[i];
+    }
+    if (_count == STATUS_MAX_FIELDS)
+        return nullptr;
+    Field &f = _fields[_count++];
+    f.name = name;
+    return &f;
+}
+
+void StatusDisplay::set(const char *name, const char *text)
+{
+    if (Field *f = find(name))
+    {
+        std::strncpy(f->text, text, STATUS_TEXT - 1);
+        f->text[STATUS_TEXT - 1] = '\0';
+    }
+}
+
+void StatusDisplay::set(const char *name, float value)
+{
+    char text[STATUS_TEXT];
+    std::snprintf(text, sizeof text, "%.2f", value);
+    set(name, text);
+}
+
+void StatusDisplay::bind(const char *name, void (*source)(char *text, int size))
+{
+    if (Field *f = find(name))
+        f->source = source;
+}
+
+void StatusDisplay::redraw()
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        _fields[i].labelled = false;
+        _fields[i].shown[0] = '\0';
+    }
+}
+
+void StatusDisplay::poll(float now)
+{
+    if (!_enabled || _count == 0)
+        return;
+    if (now - _lastDraw < STATUS_INTERVAL)
+        return;
+    _lastDraw = now;
+
+    // the next field round that's changed, if any
+    for (int n = 0; n < _count; ++n)
+    {
+        int i = (_next + n) % _count;
+        Field &f = _fields[i];
+        if (f.source)
+            f.source(f.text, STATUS_TEXT);
+        if (f.labelled && std::strcmp(f.text, f.shown) == 0)
+            continue;
+        _next = i + 1;
+
+        int row = STATUS_FIRST_ROW + i;
+        if (!f.labelled)
+        {
+            // the label gets a poll to itself; the value follows next time
+            LCD.SetFontColor(BACKGROUND);
+            LCD.FillRectangle(0, row * CHAR_HEIGHT, 320, CHAR_HEIGHT);
+            LCD.SetFontColor(FOREGROUND);
+            LCD.WriteRC(f.name, row, 0);
+            f.labelled = true;
+            f.shown[0] = '\0';
+            _next = i;
+            return;
+        }
+
+        // rewrite only the characters that changed
+        int oldLength = std::strlen(f.shown), newLength = std::strlen(f.text);
+        int first = 0;
+        while (f.text[first] && f.text[first] == f.shown[first])
+            ++first;
+        int last = std::max(oldLength, newLength);
+        while (last > first && last <= oldLength && last <= newLength && f.text[last - 1] == f.shown[last - 1])
+            --last;
+
+        LCD.SetFontColor(BACKGROUND);
+        LCD.FillRectangle((STATUS_VALUE_COL + first) * CHAR_WIDTH, row * CHAR_HEIGHT,
+                          (last - first) * CHAR_WIDTH, CHAR_HEIGHT);
+        LCD.SetFontColor(FOREGROUND);
+        if (first < newLength)
+        {
+            char span[STATUS_TEXT];
+            int length = std::min(last, newLength) - first;
+            std::memcpy(span, f.text + first, length);
+            span[length] = '\0';
+            LCD.WriteRC(span, row, STATUS_VALUE_COL + first);
+        }
+        std::strcpy(f.shown, f.text);
+        return;
+    }
+}
+
+void Console::write(int value)
+{
+    char text[16];
+    std::snprintf(text, sizeof text, "%d", value);
+    put(text, false);
+}
+
+void Console::write(float value)
+{
+    char text[32];
+    std::snprintf(text, sizeof text, "%.3f", value);
+    put(text, false);
+}
+
+void Console::writeLine(int value)
+{
+    write(value);
+    put("", true);
+}
+
+void Console::writeLine(float value)
+{
+    write(value);
+    put("", true);
+}
+
+void Console::clear()
+{
+    LCD.Clear();
+    _row = _col = 0;
+    status.redraw();
+}
+
+// where {text} leaves the cursor from {row}, {col}, wrapping as the LCD does
+static void advance(const char *text, bool newline, int &row, int &col)
+{
+    for (; *text; ++text)
+    {
+        if (*text == '\n' || ++col == CONSOLE_COLS)
+        {
+            ++row;
+            col = 0;
+        }
+    }
+    if (newline)
+    {
+        ++row;
+        col = 0;
+    }
+}
+
+void Console::put(const char *text, bool newline)
+{
+    // clear rather than leave it to the LCD to wrap or write into the overlay;
+    // a trailing newline only moves the cursor, so it may land on {last}
+    int last = status.active() ? STATUS_FIRST_ROW : CONSOLE_ROWS;
+    int row = _row, col = _col;
+    advance(text, false, row, col);
+    if (row >= last)
+    {
+        clear();
+        row = col = 0;
+        advance(text, false, row, col);
+    }
+    if (newline)
+        LCD.WriteLine(text);
+    else
+        LCD.Write(text);
+    advance("", newline, row, col);
+    _row = row;
+    _col = col;
+}
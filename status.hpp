@@ -0,0 +1,81 @@
+#pragma once
+
+// the screen in characters
+static constexpr int CONSOLE_ROWS = 14;
+static constexpr int CONSOLE_COLS = 26;
+
+static constexpr int STATUS_MAX_FIELDS = 5;
+// what fits right of the labels, and the terminator
+static constexpr int STATUS_TEXT = 18;
+// how often the overlay draws, s; each draw is one field's label or the
+// changed part of one field's value
+static constexpr float STATUS_INTERVAL = .1f;
+// the fields sit in the bottom rows of the screen
+static constexpr int STATUS_FIRST_ROW = CONSOLE_ROWS - STATUS_MAX_FIELDS;
+static constexpr int STATUS_VALUE_COL = 9;
+
+// A few named fields at the bottom of the LCD. Publishing only copies text
+// (or, for a bound source, nothing at all); poll(), which Scheduler::poll()
+// calls, redraws one changed field per STATUS_INTERVAL and only the
+// characters of it that changed, so the screen costs a control loop the
+// same small slice however often it publishes.
+class StatusDisplay
+{
+public:
+    void set(const char *name, const char *text);
+    void set(const char *name, float value);
+    // {source} formats the field when it's about to be drawn
+    void bind(const char *name, void (*source)(char *text, int size));
+
+    // {now} is TimeNow()
+    void poll(float now);
+    // draw every field again, e.g. after console.clear()
+    void redraw();
+    void enable(bool on) { _enabled = on; }
+    // whether it's holding its rows
+    bool active() const { return _enabled && _count > 0; }
+
+private:
+    struct Field
+    {
+        const char *name;
+        char text[STATUS_TEXT];
+        char shown[STATUS_TEXT];
+        void (*source)(char *text, int size);
+        bool labelled;
+    };
+
+    Field _fields[STATUS_MAX_FIELDS] = {};
+    int _count = 0, _next = 0;
+    float _lastDraw = -1.f;
+    bool _enabled = true;
+
+    Field *find(const char *name);
+};
+
+extern StatusDisplay status;
+
+// LCD.Write and WriteLine, kept out of the overlay's rows. It follows the
+// LCD's cursor, and text that would run into STATUS_FIRST_ROW while the
+// overlay's up clears the screen and starts again at the top, so console
+// and overlay never draw over each other. Everything but the menu writes
+// through this rather than to LCD directly.
+class Console
+{
+public:
+    void write(const char *text) { put(text, false); }
+    void write(int value);
+    void write(float value);
+    void writeLine(const char *text) { put(text, true); }
+    void writeLine(int value);
+    void writeLine(float value);
+    // LCD.Clear(), and the overlay drawn again
+    void clear();
+
+private:
+    int _row = 0, _col = 0;
+
+    void put(const char *text, bool newline);
+};
+
+extern Console console;
@@ -0,0 +1,135 @@
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "telemetry.hpp"
+#include "drive.hpp"
+#include "pose.hpp"
+#include "profile.hpp"
+
+Telemetry telemetry;
+
+static int16_t fixed(float value, float scale)
+{
+    float v = std::round(value * scale);
+    return v > INT16_MAX ? INT16_MAX : v < INT16_MIN ? INT16_MIN : static_cast<int16_t>(v);
+}
+
+void Telemetry::start(FEHFile *file)
+{
+    _file = file;
+    _head = _tail = 0;
+    _samples = _dropped = _overruns = 0;
+    _sampleTime = _worstSample = _flushTime = 0.f;
+    _start = _next = TimeNow();
+    SD.FPrintf(_file, "# telemetry v%d, %d byte records, %f s period\n", TELEMETRY_VERSION,
+               static_cast<int>(sizeof(TelemetryRecord)), TELEMETRY_PERIOD);
+}
+
+void Telemetry::stop()
+{
+    if (!_file)
+        return;
+    flush();
+    SD.FPrintf(_file, "# samples %d dropped %d overruns %d\n", _samples, _dropped, _overruns);
+    SD.FPrintf(_file, "# sampling %f s total, %f s mean, %f s worst; flushing %f s\n", _sampleTime,
+               _samples ? _sampleTime / _samples : 0.f, _worstSample, _flushTime);
+    SD.FClose(_file);
+    _file = nullptr;
+}
+
+void Telemetry::command(float left, float right)
+{
+    _percent[0] = static_cast<int8_t>(std::fmax(-100.f, std::fmin(100.f, left)));
+    _percent[1] = static_cast<int8_t>(std::fmax(-100.f, std::fmin(100.f, right)));
+}
+
+void Telemetry::servo(FEHServo *servo, float degree)
+{
+    for (int i = 0; i < TELEMETRY_SERVOS; ++i)
+    {
+        if (_servos[i] == servo)
+            _degree[i] = static_cast<uint8_t>(std::fmax(0.f, std::fmin(180.f, degree)));
+    }
+}
+
+void Telemetry::poll(float now)
+{
+    if (!_file || now < _next)
+        return;
+    // don't try to catch up after a long gap
+    _next = std::fmax(_next + TELEMETRY_PERIOD, now);
+
+    sample(now);
+
+    float cost = TimeNow() - now;
+    _sampleTime += cost;
+    _worstSample = std::fmax(_worstSample, cost);
+    if (cost > TELEMETRY_BUDGET)
+        ++_overruns;
+}
+
+void Telemetry::sample(float now)
+{
+    if (_head - _tail >= TELEMETRY_RECORDS)
+    {
+        // full; lose this one, since _tail is flush()'s
+        ++_dropped;
+        return;
+    }
+    TelemetryRecord &r = _ring[_head % TELEMETRY_RECORDS];
+
+    Point fix = poseEstimator.lastFix();
+    Point pose = poseEstimator.pose();
+    r.time = static_cast<uint32_t>((now - _start) * 1000.f);
+    r.leftCounts = static_cast<int16_t>(hardware().leftEncoder.Counts());
+    r.rightCounts = static_cast<int16_t>(hardware().rightEncoder.Counts());
+    r.leftPercent = _percent[0];
+    r.rightPercent = _percent[1];
+    for (int i = 0; i < TELEMETRY_SERVOS; ++i)
+        r.servo[i] = _degree[i];
+    r.rpsX = fixed(fix.x, 100.f);
+    r.rpsY = fixed(fix.y, 100.f);
+    r.rpsHeading = fixed(fix.heading, 50.f);
+    r.x = fixed(pose.x, 100.f);
+    r.y = fixed(pose.y, 100.f);
+    r.heading = fixed(pose.heading, 50.f);
+    r.cds = _cds ? static_cast<uint16_t>(_cds->Value() * 1000.f) : 0;
+
+    ++_head;
+    ++_samples;
+}
+
+void Telemetry::flush()
+{
+    if (!_file || _head == _tail)
+        return;
+    float startTime = TimeNow();
+
+    static const char digits[] = "0123456789abcdef";
+    static char text[TELEMETRY_BATCH * (2 * sizeof(TelemetryRecord) + 1) + 1];
+    while (_head != _tail)
+    {
+        char *p = text;
+        for (int n = 0; n < TELEMETRY_BATCH && _head != _tail; ++n, ++_tail)
+        {
+            const uint8_t *bytes = reinterpret_cast<const uint8_t *>(&_ring[_tail % TELEMETRY_RECORDS]);
+            for (size_t i = 0; i < sizeof(TelemetryRecord); ++i)
+            {
+                *p++ = digits[bytes[i] >> 4];
+                *p++ = digits[bytes[i] & 15];
+            }
+            *p++ = '\n';
+        }
+        *p = '\0';
+        SD.FPrintf(_file, "%s", text);
+    }
+
+    _flushTime += TimeNow() - startTime;
+}
+
+void setServo(FEHServo &servo, float degree)
+{
+    PROFILE_SCOPE("setServo");
+    servo.SetDegree(degree);
+    telemetry.servo(&servo, degree);
+}
@@ -0,0 +1,82 @@
+#pragma once
+
+#include <FEHIO.h>
+#include <FEHSD.h>
+#include <FEHServo.h>
+#include <cstdint>
+
+// 100 Hz
+static constexpr float TELEMETRY_PERIOD = .01f;
+// ~10 s of records
+static constexpr int TELEMETRY_RECORDS = 1024;
+// records per FPrintf when flushing
+static constexpr int TELEMETRY_BATCH = 32;
+static constexpr int TELEMETRY_SERVOS = 2;
+// most a sample may take, s; longer ones are counted as overruns
+static constexpr float TELEMETRY_BUDGET = .0005f;
+static constexpr int TELEMETRY_VERSION = 1;
+
+// One sample, written to SD as hex since FEHSD only does text. Fixed
+// point, little-endian; the decoder in sim/telemetry2csv.cpp reads it
+// back.
+#pragma pack(push, 1)
+struct TelemetryRecord
+{
+    uint32_t time;                   // ms
+    int16_t leftCounts, rightCounts; // since the last reset
+    int8_t leftPercent, rightPercent;
+    uint8_t servo[TELEMETRY_SERVOS]; // degrees
+    int16_t rpsX, rpsY;              // 1/100 in, last fix
+    int16_t rpsHeading;              // 1/50 degree
+    int16_t x, y;                    // 1/100 in, estimate
+    int16_t heading;                 // 1/50 degree
+    uint16_t cds;                    // mV
+};
+#pragma pack(pop)
+
+// Samples the robot into a fixed ring from poll(), which Scheduler::poll()
+// calls, so every motion loop records without doing anything itself.
+// Records only reach SD on flush(), which the scheduler calls when it's
+// idle (waits, task marks); if the ring fills first new records are dropped.
+// There's one producer and one consumer and each only moves its own index.
+class Telemetry
+{
+public:
+    void start(FEHFile *file);
+    // flushes everything, writes the overhead summary and closes the file
+    void stop();
+
+    // {now} is TimeNow()
+    void poll(float now);
+    void flush();
+
+    void watchCds(AnalogInputPin *cds) { _cds = cds; }
+    void watchServo(int slot, FEHServo *servo) { _servos[slot] = servo; }
+    void command(float left, float right);
+    void servo(FEHServo *servo, float degree);
+
+    bool recording() const { return _file; }
+    int dropped() const { return _dropped; }
+    // s spent sampling, in all and at worst
+    float sampleTime() const { return _sampleTime; }
+    float worstSample() const { return _worstSample; }
+
+private:
+    TelemetryRecord _ring[TELEMETRY_RECORDS];
+    volatile uint32_t _head = 0, _tail = 0; // written, flushed
+    FEHFile *_file = nullptr;
+    float _next = 0.f, _start = 0.f;
+    AnalogInputPin *_cds = nullptr;
+    FEHServo *_servos[TELEMETRY_SERVOS] = {};
+    int8_t _percent[2] = {};
+    uint8_t _degree[TELEMETRY_SERVOS] = {};
+    int _samples = 0, _dropped = 0, _overruns = 0;
+    float _sampleTime = 0.f, _worstSample = 0.f, _flushTime = 0.f;
+
+    void sample(float now);
+};
+
+extern Telemetry telemetry;
+
+// SetDegree, and tell telemetry
+void setServo(FEHServo &servo, float degree);
@@ -0,0 +1,344 @@
+#include <FEHUtility.h>
+#include <cmath>
+
+#include "trajectory.hpp"
+#include "pose.hpp"
+#include "motors.hpp"
+#include "profile.hpp"
+#include "scheduler.hpp"
+#include "watchdog.hpp"
+
+static float turnTime(float degrees)
+{
+    float d = std::fabs(degrees);
+    if (d <= HEADING_THRESHOLD)
+        return 0.f;
+    // headingTurnTo runs flat out and brakes at TURN_ACCEL
+    float braking = TURN_MAX_RATE * TURN_MAX_RATE / (2.f * TURN_ACCEL);
+    float t = d < braking ? std::sqrt(2.f * d / TURN_ACCEL) : (d - braking) / TURN_MAX_RATE + TURN_MAX_RATE / TURN_ACCEL;
+    return t + TRAJ_TURN_SETTLE;
+}
+
+float arcSpeedLimit(float curvature)
+{
+    float k = std::fabs(curvature);
+    float v = DRIVE_MAX_SPEED / (1.f + k * AXLETRACK / 2.f);
+    if (k > 0.f)
+        v = std::fmin(v, std::sqrt(TRAJ_MAX_LATERAL / k));
+    return v;
+}
+
+static float pathSpeed(const Segment *arcs, int n, float s, float length);
+
+// the follower's own speed profile, integrated along the path
+static float driveTime(const Segment *arcs, int n)
+{
+    float length = 0.f;
+    for (int i = 0; i < n; ++i)
+        length += arcs[i].value;
+    float t = 0.f;
+    for (float s = 0.f; s < length; s += TRAJ_STEP)
+        t += std::fmin(TRAJ_STEP, length - s) / pathSpeed(arcs, n, s, length);
+    return t;
+}
+
+static void estimate(Trajectory &t, Point from)
+{
+    t.time = 0.f;
+    float heading = from.heading;
+    for (int i = 0; i < t.count; ++i)
+    {
+        Segment &s = t.segments[i];
+        if (s.kind == Segment::PIVOT)
+        {
+            t.time += turnTime(wrapDegrees(s.value - heading));
+            heading = s.value;
+            continue;
+        }
+        int j = i;
+        while (j < t.count && t.segments[j].kind == Segment::ARC)
+        {
+            heading += t.segments[j].value * t.segments[j].curvature / RAD;
+            ++j;
+        }
+        t.time += driveTime(&t.segments[i], j - i);
+        i = j - 1;
+    }
+}
+
+// the arc leaving {from} along {heading} (degrees) that passes through {to}
+static bool arcThrough(float fx, float fy, float heading, float tx, float ty, Segment &arc)
+{
+    float cx = tx - fx, cy = ty - fy;
+    float chord = std::sqrt(cx * cx + cy * cy);
+    float ux = std::cos(heading * RAD), uy = std::sin(heading * RAD);
+    float alpha = std::atan2(ux * cy - uy * cx, ux * cx + uy * cy);
+    if (std::fabs(alpha) >= M_PI / 2.f)
+        return false;
+    arc.kind = Segment::ARC;
+    if (std::fabs(alpha) < 1e-4f)
+    {
+        arc.value = chord;
+        arc.curvature = 0.f;
+    }
+    else
+    {
+        arc.value = chord * alpha / std::sin(alpha);
+        arc.curvature = 2.f * std::sin(alpha) / chord;
+    }
+    return chord > 0.f;
+}
+
+static void finalTurn(Trajectory &t, float heading, Point to, bool withHeading)
+{
+    if (withHeading && std::fabs(wrapDegrees(to.heading - heading)) > HEADING_THRESHOLD)
+        t.segments[t.count++] = {Segment::PIVOT, to.heading, 0.f};
+}
+
+Trajectory planPivot(Point from, Point to, bool withHeading)
+{
+    Trajectory t = {"pivot", {}, 0, 0.f};
+    float bearing = getHeadingToPoint(from, to);
+    t.segments[t.count++] = {Segment::PIVOT, bearing, 0.f};
+    t.segments[t.count++] = {Segment::ARC, pythagoreanDistance(from, to), 0.f};
+    finalTurn(t, bearing, to, withHeading);
+    estimate(t, from);
+    return t;
+}
+
+Trajectory planArc(Point from, Point to, bool withHeading)
+{
+    Trajectory t = {"arc", {}, 0, 0.f};
+    float distance = pythagoreanDistance(from, to);
+    float bearing = wrapDegrees(getHeadingToPoint(from, to) - from.heading);
+
+    // the most we can take on in the arc; pivot through the rest
+    float limit = std::fmin(TRAJ_MAX_BEARING, std::asin(std::fmin(1.f, TRAJ_MAX_CURVATURE * distance / 2.f)) / RAD);
+    float arcBearing = std::copysign(std::fmin(std::fabs(bearing), limit), bearing);
+    float heading = from.heading;
+    if (std::fabs(bearing - arcBearing) > HEADING_THRESHOLD)
+    {
+        heading = (Angle(from.heading) + bearing - arcBearing).degrees();
+        t.segments[t.count++] = {Segment::PIVOT, heading, 0.f};
+    }
+    else
+    {
+        arcBearing = bearing;
+    }
+
+    Segment arc;
+    if (!arcThrough(from.x, from.y, heading, to.x, to.y, arc))
+    {
+        t.time = INFINITY;
+        return t;
+    }
+    t.segments[t.count++] = arc;
+    finalTurn(t, (Angle(heading) + 2.f * arcBearing).degrees(), to, withHeading);
+    estimate(t, from);
+    return t;
+}
+
+Trajectory planBiarc(Point from, Point to)
+{
+    Trajectory t = {"biarc", {}, 0, INFINITY};
+    float t0x = std::cos(from.heading * RAD), t0y = std::sin(from.heading * RAD);
+    float t1x = std::cos(to.heading * RAD), t1y = std::sin(to.heading * RAD);
+    float vx = to.x - from.x, vy = to.y - from.y;
+
+    // equal tangent lengths d: |v - d(t0 + t1)| = 2d
+    float vt = vx * (t0x + t1x) + vy * (t0y + t1y);
+    float vv = vx * vx + vy * vy;
+    float denom = 2.f * (1.f - (t0x * t1x + t0y * t1y));
+    float d;
+    if (denom < 1e-4f)
+    {
+        float vt1 = vx * t1x + vy * t1y;
+        if (vt1 <= 0.f)
+            return t;
+        d = vv / (4.f * vt1);
+    }
+    else
+    {
+        d = (-vt + std::sqrt(vt * vt + denom * vv)) / denom;
+    }
+    if (!(d > 0.f))
+        return t;
+
+    float q0x = from.x + d * t0x, q0y = from.y + d * t0y;
+    float q1x = to.x - d * t1x, q1y = to.y - d * t1y;
+    float mx = (q0x + q1x) / 2.f, my = (q0y + q1y) / 2.f;
+    float midHeading = std::atan2(q1y - q0y, q1x - q0x) / RAD;
+
+    Segment first, second;
+    if (!arcThrough(from.x, from.y, from.heading, mx, my, first) || !arcThrough(mx, my, midHeading, to.x, to.y, second))
+        return t;
+    if (std::fabs(first.curvature) > TRAJ_MAX_CURVATURE || std::fabs(second.curvature) > TRAJ_MAX_CURVATURE)
+        return t;
+
+    t.segments[t.count++] = first;
+    t.segments[t.count++] = second;
+    estimate(t, from);
+    return t;
+}
+
+Trajectory planFastest(Point from, Point to, bool withHeading)
+{
+    Trajectory best = planPivot(from, to, withHeading);
+    Trajectory arc = planArc(from, to, withHeading);
+    if (arc.time < best.time)
+        best = arc;
+    if (withHeading)
+    {
+        Trajectory biarc = planBiarc(from, to);
+        if (biarc.time < best.time)
+            best = biarc;
+    }
+    return best;
+}
+
+// where the path from {start} puts us {s} inches along {arcs}
+static Point pathPoint(Point start, const Segment *arcs, int n, float s)
+{
+    Point p = start;
+    for (int i = 0; i < n && s > 0.f; ++i)
+    {
+        float u = std::fmin(s, arcs[i].value), k = arcs[i].curvature;
+        float h0 = p.heading * RAD, h1 = h0 + k * u;
+        if (std::fabs(k) < 1e-6f)
+        {
+            p.x += u * std::cos(h0);
+            p.y += u * std::sin(h0);
+        }
+        else
+        {
+            p.x += (std::sin(h1) - std::sin(h0)) / k;
+            p.y -= (std::cos(h1) - std::cos(h0)) / k;
+        }
+        p.heading = Angle(toDegrees(h1)).degrees();
+        s -= u;
+    }
+    return p;
+}
+
+static float pathSpeed(const Segment *arcs, int n, float s, float length)
+{
+    float creepStart = std::fmax(0.f, length - DRIVE_CREEP_DISTANCE);
+    float v2 = DRIVE_CREEP_SPEED * DRIVE_CREEP_SPEED;
+    float v = std::fmin(std::sqrt(v2 + 2.f * DRIVE_ACCEL * std::fmax(0.f, s)),
+                        std::sqrt(v2 + 2.f * DRIVE_ACCEL * std::fmax(0.f, creepStart - s)));
+    // each segment's limit, and slowing down in time for it
+    float begin = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        float limit = arcSpeedLimit(arcs[i].curvature);
+        if (s < begin)
+            limit = std::sqrt(limit * limit + 2.f * DRIVE_ACCEL * (begin - s));
+        else if (s > begin + arcs[i].value)
+            limit = INFINITY;
+        v = std::fmin(v, limit);
+        begin += arcs[i].value;
+    }
+    return v;
+}
+
+// drives a run of arcs as one motion: a speed profile along the whole path,
+// held on the encoders, with the curvature trimmed by how far the pose
+// estimate is off the path. Stops on the estimate like profiledMoveInline.
+static void followArcs(const Segment *arcs, int n, Point to)
+{
+    PROFILE_SCOPE("followArcs");
+    if (watchdog.tripped())
+        return;
+    float length = 0.f;
+    for (int i = 0; i < n; ++i)
+        length += arcs[i].value;
+
+    Point start = poseEstimator.pose();
+    bool useRps = poseEstimator.valid();
+    Point end = pathPoint(start, arcs, n, length);
+    float ex = std::cos(end.heading * RAD), ey = std::sin(end.heading * RAD);
+    if (!useRps)
+        to = end;
+
+    resetEncoders();
+
+    float startTime = TimeNow(), lastTime = startTime;
+    float timeout = driveTime(arcs, n) + 2.f;
+    float setpoint = 0.f;
+    int passes = 0;
+
+    while (TimeNow() - startTime < timeout && !watchdog.tripped())
+    {
+        scheduler.poll();
+        ++passes;
+
+        float now = TimeNow();
+        float dt = now - lastTime;
+        lastTime = now;
+
+        float travelled = (hardware().leftEncoder.Counts() + hardware().rightEncoder.Counts()) / (2.f * COUNTS_PER_LINEAR_INCH);
+        Point pose = poseEstimator.pose();
+
+        if (travelled >= length - DRIVE_CREEP_DISTANCE)
+        {
+            float remaining = (to.x - pose.x) * ex + (to.y - pose.y) * ey;
+            if ((useRps && remaining <= 0.f) || travelled >= length + (useRps ? DRIVE_CREEP_DISTANCE : 0.f))
+                break;
+        }
+
+        // which segment we're on, and how far off it we are
+        float s = std::fmin(travelled, length);
+        float k = arcs[n - 1].curvature, begin = 0.f;
+        for (int i = 0; i < n; ++i)
+        {
+            if (s <= begin + arcs[i].value)
+            {
+                k = arcs[i].curvature;
+                break;
+            }
+            begin += arcs[i].value;
+        }
+        if (useRps)
+        {
+            Point ref = pathPoint(start, arcs, n, s);
+            float h = ref.heading * RAD;
+            float offset = -(pose.x - ref.x) * std::sin(h) + (pose.y - ref.y) * std::cos(h);
+            k -= TRAJ_KY * offset + TRAJ_KH * wrapDegrees(pose.heading - ref.heading);
+        }
+
+        float speed = pathSpeed(arcs, n, setpoint, length);
+        setpoint = std::fmin(setpoint + speed * dt, travelled + DRIVE_MAX_LEAD);
+        float push = DRIVE_KP * (setpoint - travelled);
+        float left = speed * (1.f - k * AXLETRACK / 2.f);
+        float right = speed * (1.f + k * AXLETRACK / 2.f);
+        setMotors(motorMap.percent(MotorMap::LEFT, left) + push, motorMap.percent(MotorMap::RIGHT, right) + push);
+    }
+
+    setMotors(0.f, 0.f);
+    PROFILE_COUNT("followArcs polls", passes);
+}
+
+void runTrajectory(const Trajectory &trajectory, Point to)
+{
+    for (int i = 0; i < trajectory.count; ++i)
+    {
+        const Segment &s = trajectory.segments[i];
+        if (s.kind == Segment::PIVOT)
+        {
+            turnTo(s.value);
+            continue;
+        }
+        int j = i;
+        while (j < trajectory.count && trajectory.segments[j].kind == Segment::ARC)
+            ++j;
+        // a pivot never lands exactly on its heading, so re-aim a lone arc
+        // through the target from wherever it did leave us
+        Segment arc = trajectory.segments[i];
+        Point pose = poseEstimator.pose();
+        if (j - i == 1 && poseEstimator.valid() && arcThrough(pose.x, pose.y, pose.heading, to.x, to.y, arc))
+            followArcs(&arc, 1, to);
+        else
+            followArcs(&trajectory.segments[i], j - i, to);
+        i = j - 1;
+    }
+}
@@ -0,0 +1,51 @@
+#pragma once
+
+#include "drive.hpp"
+
+// the tightest turn we'll drive: inner wheel at a third of the outer
+static constexpr float TRAJ_MAX_CURVATURE = 1.f / AXLETRACK;
+// in/s^2 sideways; keeps the speed down on tight arcs
+static constexpr float TRAJ_MAX_LATERAL = 30.f;
+// past this bearing to the target, pivot part of the way first
+static constexpr float TRAJ_MAX_BEARING = 60.f;
+// curvature correction per inch off the path and per degree off heading
+static constexpr float TRAJ_KY = .1f;
+static constexpr float TRAJ_KH = .02f;
+// time headingTurnTo spends confirming a turn, for the estimates
+static constexpr float TRAJ_TURN_SETTLE = .05f;
+// inches per step when integrating a path's drive time
+static constexpr float TRAJ_STEP = .1f;
+static constexpr int TRAJ_MAX_SEGMENTS = 4;
+
+struct Segment
+{
+    enum Kind
+    {
+        PIVOT, // turn in place to {value} degrees
+        ARC    // drive {value} inches at {curvature} (1/in, positive is left)
+    } kind;
+    float value;
+    float curvature;
+};
+
+struct Trajectory
+{
+    const char *name;
+    Segment segments[TRAJ_MAX_SEGMENTS];
+    int count;
+    float time; // estimated, s; infinite if the plan isn't drivable
+};
+
+// pivot to face the target, drive straight, pivot to its heading
+Trajectory planPivot(Point from, Point to, bool withHeading);
+// one arc to the target (pivoting first if it's too far round), then
+// pivot to its heading
+Trajectory planArc(Point from, Point to, bool withHeading);
+// two arcs that arrive at the target already on its heading
+Trajectory planBiarc(Point from, Point to);
+Trajectory planFastest(Point from, Point to, bool withHeading);
+
+// in/s, for the center of the robot on an arc of {curvature}
+float arcSpeedLimit(float curvature);
+
+void runTrajectory(const Trajectory &trajectory, Point to);
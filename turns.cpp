@@ -0,0 +1,104 @@
+#include <cmath>
+
+#include "turns.hpp"
+
+TurnTable turnTable;
+
+bool TurnTable::load(FEHFile *f)
+{
+    clear();
+    if (!f)
+        return false;
+    Row row;
+    while (_count < TURN_TABLE_ROWS &&
+           SD.FScanf(f, "%d%f%f%f%f%d", &row.dir, &row.percent, &row.gain, &row.offset, &row.rms, &row.samples) == 6)
+    {
+        if (row.gain > 0.f)
+            add(row);
+    }
+    return _count > 0;
+}
+
+void TurnTable::save(FEHFile *f) const
+{
+    for (int i = 0; i < _count; ++i)
+    {
+        const Row &r = _rows[i];
+        SD.FPrintf(f, "%d\t%f\t%f\t%f\t%f\t%d\n", r.dir, r.percent, r.gain, r.offset, r.rms, r.samples);
+    }
+}
+
+void TurnTable::add(const Row &row)
+{
+    if (_count == TURN_TABLE_ROWS)
+        return;
+    int i = _count++;
+    for (; i > 0 && _rows[i - 1].percent > row.percent; --i)
+        _rows[i] = _rows[i - 1];
+    _rows[i] = row;
+}
+
+float TurnTable::command(float degrees, float percent) const
+{
+    int dir = degrees < 0.f ? -1 : 1;
+
+    // interpolate between the rows either side of {percent}, or take the
+    // nearest one past the ends
+    const Row *below = nullptr, *above = nullptr;
+    for (int i = 0; i < _count; ++i)
+    {
+        const Row &r = _rows[i];
+        if (r.dir != dir)
+            continue;
+        if (r.percent <= percent)
+            below = &r;
+        else if (!above)
+            above = &r;
+    }
+    if (!below && !above)
+        return degrees;
+    if (!below)
+        below = above;
+    if (!above)
+        above = below;
+    float t = above->percent > below->percent ? (percent - below->percent) / (above->percent - below->percent) : 0.f;
+    float gain = below->gain + t * (above->gain - below->gain);
+    float offset = below->offset + t * (above->offset - below->offset);
+
+    float magnitude = std::fabs(degrees);
+    offset *= std::fmin(1.f, magnitude / TURN_SWEEP_STEP);
+    return std::copysign(std::fmax(0.f, (magnitude - offset) / gain), degrees);
+}
+
+TurnTable::Row TurnTable::fit(int dir, float percent, const float *asked, const float *achieved, int n)
+{
+    Row row = {dir, percent, 1.f, 0.f, 0.f, n};
+    if (n < 2)
+        return row;
+
+    float meanAsked = 0.f, meanAchieved = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        meanAsked += asked[i] / n;
+        meanAchieved += achieved[i] / n;
+    }
+    float covariance = 0.f, variance = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        covariance += (asked[i] - meanAsked) * (achieved[i] - meanAchieved);
+        variance += (asked[i] - meanAsked) * (asked[i] - meanAsked);
+    }
+    if (variance <= 0.f || covariance <= 0.f)
+        return row;
+    row.gain = covariance / variance;
+    row.offset = meanAchieved - row.gain * meanAsked;
+
+    float squares = 0.f;
+    for (int i = 0; i < n; ++i)
+    {
+        float residual = achieved[i] - (row.gain * asked[i] + row.offset);
+        squares += residual * residual;
+    }
+    row.rms = std::sqrt(squares / n);
+    return row;
+}
@@ -0,0 +1,52 @@
+#pragma once
+
+#include <FEHSD.h>
+
+// the characterization sweep in CDSModule: every multiple of the step up
+// to the max, each way, at each percent
+static constexpr float TURN_SWEEP_PERCENTS[] = {25.f, 30.f, 40.f};
+static constexpr float TURN_SWEEP_STEP = 15.f;
+static constexpr float TURN_SWEEP_MAX = 180.f;
+static constexpr int TURN_SWEEP_TURNS = static_cast<int>(TURN_SWEEP_MAX / TURN_SWEEP_STEP);
+
+static constexpr int TURN_TABLE_ROWS = 8;
+
+// How far pivotTurn really goes for what it asks of the encoders, by
+// direction and motor percent: achieved = gain * asked + offset, fitted by
+// least squares to the sweep and kept in turns.txt. COUNTS_PER_DEGREE
+// already has CORRECTION_MULTIPLIER's fixed allowance for scrub in it, so
+// the gain is whatever scrub that leaves, per percent and direction; the
+// offset is mostly the coast once the motors stop. Turns shorter than the
+// sweep's step have the offset faded out so the 0.5 degree pulses still
+// move. With no table, turns are taken as asked.
+class TurnTable
+{
+public:
+    struct Row
+    {
+        int dir; // 1 counterclockwise, -1 clockwise
+        float percent, gain, offset;
+        float rms; // degrees, what the fit left over
+        int samples;
+    };
+
+    void clear() { _count = 0; }
+    bool load(FEHFile *f);
+    void save(FEHFile *f) const;
+    // kept sorted by percent
+    void add(const Row &row);
+    int count() const { return _count; }
+    const Row &row(int i) const { return _rows[i]; }
+
+    // what to ask of the encoders to turn {degrees} at {percent}
+    float command(float degrees, float percent) const;
+
+    // {asked} and {achieved} are magnitudes, all turns one way at one percent
+    static Row fit(int dir, float percent, const float *asked, const float *achieved, int n);
+
+private:
+    Row _rows[TURN_TABLE_ROWS];
+    int _count = 0;
+};
+
+extern TurnTable turnTable;
@@ -0,0 +1,199 @@
+#include <FEHLCD.h>
+#include <FEHUtility.h>
+#include <cmath>
+#include <cstring>
+
+#include "watchdog.hpp"
+#include "drive.hpp"
+#include "encoders.hpp"
+#include "motors.hpp"
+#include "status.hpp"
+
+MotionWatchdog watchdog;
+
+const char *faultName(WatchdogFault fault)
+{
+    static const char *const names[] = {"none", "stall", "no progress", "budget"};
+    return names[fault];
+}
+
+void MotionWatchdog::begin(const char *name, float budget)
+{
+    std::strncpy(_task, name, WATCHDOG_NAME_LEN - 1);
+    _task[WATCHDOG_NAME_LEN - 1] = '\0';
+    _deadline = TimeNow() + budget;
+    _remaining = -1.f;
+    clear();
+}
+
+void MotionWatchdog::end()
+{
+    _deadline = _remaining = -1.f;
+}
+
+void MotionWatchdog::suspend()
+{
+    if (_deadline < 0.f)
+        return;
+    _remaining = _deadline - TimeNow();
+    _deadline = -1.f;
+}
+
+void MotionWatchdog::resume()
+{
+    if (_remaining < 0.f)
+        return;
+    _deadline = TimeNow() + _remaining;
+    _remaining = -1.f;
+}
+
+void MotionWatchdog::command(float left, float right)
+{
+    float commands[2] = {left, right};
+    for (int side = MotorMap::LEFT; side <= MotorMap::RIGHT; ++side)
+    {
+        float was = _commanded[side], now = commands[side];
+        _commanded[side] = now;
+        // the spin-up grace starts over when a wheel sets off or reverses;
+        // it's the only clock read here, and not every command needs it
+        bool going = std::fabs(motorMap.speed(side, now)) >= STALL_MIN_SPEED;
+        if (!going)
+            _moving[side] = -1.f;
+        else if (_moving[side] < 0.f || (was < 0.f) != (now < 0.f))
+            _moving[side] = TimeNow();
+    }
+    if (left != 0.f || right != 0.f)
+    {
+        _lastLeft = left;
+        _lastRight = right;
+    }
+}
+
+void MotionWatchdog::poll(float now)
+{
+    if (!_enabled || tripped())
+        return;
+    if (_deadline >= 0.f && now >= _deadline)
+    {
+        trip(FAULT_BUDGET);
+        return;
+    }
+
+    // encoders only count, so this is speed whichever way the wheel's going
+    float measured[2] = {encoderMonitor.leftVelocity() / COUNTS_PER_LINEAR_INCH,
+                         encoderMonitor.rightVelocity() / COUNTS_PER_LINEAR_INCH};
+    for (int side = MotorMap::LEFT; side <= MotorMap::RIGHT; ++side)
+    {
+        float expected = std::fabs(motorMap.speed(side, _commanded[side]));
+        if (_moving[side] < 0.f || now - _moving[side] < STALL_GRACE || measured[side] >= STALL_FRACTION * expected)
+        {
+            _slow[side] = -1.f;
+            continue;
+        }
+        if (_slow[side] < 0.f)
+            _slow[side] = now;
+        else if (now - _slow[side] >= STALL_TIME)
+        {
+            trip(FAULT_STALL);
+            return;
+        }
+    }
+}
+
+void MotionWatchdog::trip(WatchdogFault fault)
+{
+    if (tripped())
+        return;
+    _fault = fault;
+    // straight if both wheels went the same way, else turning
+    _direction = (_lastLeft > 0.f) == (_lastRight > 0.f) ? std::copysign(1.f, _lastLeft + _lastRight) : 0.f;
+    setMotors(0.f, 0.f);
+    encoderMonitor.cancelAll();
+
+    if (_nevents < WATCHDOG_MAX_EVENTS)
+    {
+        Event &e = _events[_nevents++];
+        e.time = TimeNow();
+        std::strcpy(e.task, _task);
+        e.fault = fault;
+        e.action = "-";
+    }
+    console.write("Watchdog: ");
+    console.write(faultName(fault));
+    console.write(" in ");
+    console.writeLine(_task);
+}
+
+void MotionWatchdog::clear()
+{
+    _fault = FAULT_NONE;
+    _slow[MotorMap::LEFT] = _slow[MotorMap::RIGHT] = -1.f;
+}
+
+void MotionWatchdog::resolve(const char *action)
+{
+    if (_nevents > 0)
+        _events[_nevents - 1].action = action;
+}
+
+void MotionWatchdog::write(FEHFile *f) const
+{
+    SD.FPrintf(f, "# time\ttask\tfault\taction\n");
+    for (int i = 0; i < _nevents; ++i)
+    {
+        const Event &e = _events[i];
+        SD.FPrintf(f, "%f\t%s\t%s\t%s\n", e.time, e.task, faultName(e.fault), e.action);
+    }
+    SD.FPrintf(f, "# %d trips\n", _nevents);
+}
+
+bool Convergence::update(float error)
+{
+    if (watchdog.tripped())
+        return false;
+    float now = TimeNow();
+    if (_since < 0.f || error <= 0.f || error <= _best - _resolution)
+    {
+        _best = error;
+        _since = now;
+    }
+    else if (now - _since >= CONVERGE_WINDOW)
+    {
+        watchdog.trip(FAULT_NO_PROGRESS);
+        return false;
+    }
+    return true;
+}
+
+int loadRecovery(FEHFile *file, RecoveryPolicy *policies)
+{
+    if (!file)
+        return 0;
+    static const char *const strategies[] = {"skip", "backoff", "retry"};
+    int n = 0;
+    char strategy[16];
+    RecoveryPolicy p;
+    while (n < RECOVERY_MAX_POLICIES && SD.FScanf(file, "%15s%15s%f%d", p.name, strategy, &p.budget, &p.attempts) == 4)
+    {
+        int s = 0;
+        while (s < 3 && std::strcmp(strategy, strategies[s]) != 0)
+            ++s;
+        if (s == 3 || p.budget <= 0.f || p.attempts < 1)
+            break;
+        p.strategy = static_cast<RecoveryStrategy>(s);
+        policies[n++] = p;
+    }
+    return n;
+}
+
+RecoveryPolicy findRecovery(const RecoveryPolicy *policies, int n, const char *name)
+{
+    for (int i = 0; i < n; ++i)
+    {
+        if (std::strcmp(policies[i].name, name) == 0)
+            return policies[i];
+    }
+    RecoveryPolicy p = {"", RECOVER_RETRY, RECOVERY_BUDGET, RECOVERY_ATTEMPTS};
+    std::strncpy(p.name, name, WATCHDOG_NAME_LEN - 1);
+    return p;
+}
@@ -0,0 +1,130 @@
+#pragma once
+
+#include <FEHSD.h>
+
+// a wheel asked for at least this speed, in/s...
+static constexpr float STALL_MIN_SPEED = 1.5f;
+// ...that turns at less than this share of it...
+static constexpr float STALL_FRACTION = .25f;
+// ...for this long, s, is stalled; it gets this long to spin up first
+static constexpr float STALL_TIME = .3f;
+static constexpr float STALL_GRACE = .3f;
+// a loop closing on an error that hasn't set a new best for this long, s,
+// isn't going to get there
+static constexpr float CONVERGE_WINDOW = 2.f;
+static constexpr int WATCHDOG_MAX_EVENTS = 16;
+static constexpr int WATCHDOG_NAME_LEN = 16;
+
+// what a task gets when recovery.txt doesn't mention it
+static constexpr float RECOVERY_BUDGET = 25.f;
+static constexpr int RECOVERY_ATTEMPTS = 2;
+static constexpr int RECOVERY_MAX_POLICIES = 8;
+// how far to back off from whatever stopped us, in, and how fast
+static constexpr float RECOVERY_BACKOFF = 2.f;
+static constexpr int RECOVERY_PERCENT = 40;
+
+enum WatchdogFault { FAULT_NONE, FAULT_STALL, FAULT_NO_PROGRESS, FAULT_BUDGET };
+
+// Stops motion that isn't getting anywhere. Stalls are a wheel turning
+// much slower than its command asks (by motorMap, against the encoder
+// monitor's velocity); non-convergence is reported by the loops that close
+// on RPS (Convergence below); the budget is how long the current task may
+// take. poll(), which Scheduler::poll() calls, checks the first and last.
+//
+// A trip stops the motors, cancels every encoder target and latches: every
+// motion primitive returns straight away until clear(), so the rest of a
+// stuck task falls through in moments and whoever runs it (CourseRunner)
+// decides how to recover.
+class MotionWatchdog
+{
+public:
+    // starts {name}'s budget of {budget} s and clears any fault
+    void begin(const char *name, float budget);
+    void end();
+    // stop and restart the budget's clock, e.g. around a planned wait
+    void suspend();
+    void resume();
+    // off, nothing but an explicit trip() trips it
+    void enable(bool on) { _enabled = on; }
+
+    // setMotors() reports every command
+    void command(float left, float right);
+    // {now} is TimeNow()
+    void poll(float now);
+
+    void trip(WatchdogFault fault);
+    bool tripped() const { return _fault != FAULT_NONE; }
+    WatchdogFault fault() const { return _fault; }
+    void clear();
+    // how CourseRunner dealt with the last trip, for the log
+    void resolve(const char *action);
+    // which way we were driving when it tripped: 1 forward, -1 back, 0 turning
+    float direction() const { return _direction; }
+
+    // every trip: when, in what task, why and what was done about it
+    void write(FEHFile *f) const;
+
+private:
+    struct Event
+    {
+        float time;
+        char task[WATCHDOG_NAME_LEN];
+        WatchdogFault fault;
+        const char *action;
+    };
+
+    bool _enabled = true;
+    WatchdogFault _fault = FAULT_NONE;
+    char _task[WATCHDOG_NAME_LEN] = "-";
+    float _deadline = -1.f, _remaining = -1.f;
+
+    float _commanded[2] = {};
+    float _moving[2] = {-1.f, -1.f}; // when each wheel was told to go
+    float _slow[2] = {-1.f, -1.f};   // when it fell behind its command
+    float _lastLeft = 0.f, _lastRight = 0.f;
+    float _direction = 0.f;
+
+    Event _events[WATCHDOG_MAX_EVENTS] = {};
+    int _nevents = 0;
+};
+
+// For a loop closing on an error: update() it with how far outside what it
+// accepts each new error is (zero or less is always progress), and once
+// that hasn't beaten its best by {resolution} for CONVERGE_WINDOW, it
+// trips the watchdog and returns false.
+class Convergence
+{
+public:
+    explicit Convergence(float resolution) : _resolution(resolution) {}
+    bool update(float error);
+    void reset() { _since = -1.f; }
+
+private:
+    float _resolution;
+    float _best = 0.f, _since = -1.f;
+};
+
+enum RecoveryStrategy { RECOVER_SKIP, RECOVER_BACK_OFF, RECOVER_RETRY };
+
+// One line of recovery.txt:
+//   task strategy budget attempts
+// {strategy} is skip, backoff (back off, then skip) or retry (back off and
+// go round again, up to {attempts} goes in all); {budget} is s for getting
+// to the task and doing it, planned waits aside.
+struct RecoveryPolicy
+{
+    char name[WATCHDOG_NAME_LEN];
+    RecoveryStrategy strategy;
+    float budget;
+    int attempts;
+};
+
+// policies read into {policies}, at most RECOVERY_MAX_POLICIES, up to the
+// first malformed line; 0 if {file} is missing
+int loadRecovery(FEHFile *file, RecoveryPolicy *policies);
+// {name}'s, or the default
+RecoveryPolicy findRecovery(const RecoveryPolicy *policies, int n, const char *name);
+
+const char *faultName(WatchdogFault fault);
+
+extern MotionWatchdog watchdog;